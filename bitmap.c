@@ -0,0 +1,482 @@
+/*bitmap.c*/
+
+//
+// Project: Bitmap indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <ctype.h>   // tolower
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int32_t, uint16_t, uint64_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memcpy, memcmp, memset, strcpy, strcat
+
+#include "bitmap.h"
+#include "colcache.h"
+#include "database.h"
+#include "decoder.h"
+#include "sidecar.h"
+#include "tablefile.h"
+#include "util.h"
+
+#define BITMAP_MAGIC "SSQLBMP1"
+
+//
+// On-disk layout: a BitmapHeader, followed by one BitmapValue per
+// distinct value, followed by the BitmapContainers of each value,
+// the values themselves (lower-cased and null-terminated), and then
+// the contents of the containers, each starting on an 8-byte
+// boundary. Offsets are from the start of the file.
+//
+struct BitmapHeader
+{
+  struct SidecarStamp stamp;  // the .data file the index was built from
+  int32_t             column;
+  int32_t             colType;
+  int32_t             lowCardinality;  // 0 => no values follow
+  int32_t             numValues;
+};
+
+struct BitmapValue
+{
+  uint64_t keyOffset;        // the value, lower-cased
+  uint64_t containerOffset;  // its array of BitmapContainers
+  int32_t  keyLength;
+  int32_t  numContainers;
+  int32_t  cardinality;      // # of records with the value
+  int32_t  unused;
+};
+
+struct BitmapContainer
+{
+  int32_t  chunk;        // record #s chunk*65536 .. chunk*65536+65535
+  int32_t  cardinality;  // <= BITMAP_MAX_ARRAY_SIZE => an array, else bitmap
+  uint64_t offset;       // the uint16_t array, or the uint64_t bitmap
+};
+
+#define BITMAP_WORDS (BITMAP_CHUNK_RECORDS / 64)
+
+// one distinct value and the records that have it, while building
+struct Distinct
+{
+  char* key;  // lower-cased
+  int   keyLength;
+  int*  recNums;
+  int   numRecNums;
+  int   capacity;
+};
+
+// builds ".COLUMN-NAME.bmap", the extension of the index's sidecar
+static void buildExtension(char *ext, struct TableMeta *tablemeta, int column) {
+  strcpy(ext, ".");
+  strcat(ext, tablemeta->columns[column].name);
+  strcat(ext, ".bmap");
+}
+
+// rounds n up to the next multiple of 8
+static uint64_t align8(uint64_t n) { return (n + 7) & ~(uint64_t)7; }
+
+// returns the BitmapValue and containers of the given value
+static const struct BitmapValue *findValue(struct BitmapIndex *bitmap,
+                                           int valueNum) {
+  return (const struct BitmapValue *)(bitmap->data +
+                                      sizeof(struct BitmapHeader)) +
+         valueNum;
+}
+
+static const struct BitmapContainer *
+findContainers(struct BitmapIndex *bitmap, const struct BitmapValue *value) {
+  return (const struct BitmapContainer *)(bitmap->data +
+                                          value->containerOffset);
+}
+
+// returns the # of containers needed for the given record #s
+static int countContainers(const int *recNums, int n) {
+  int count = 0;
+  for (int i = 0; i < n; i++) {
+    if (i == 0 || recNums[i] / BITMAP_CHUNK_RECORDS !=
+                      recNums[i - 1] / BITMAP_CHUNK_RECORDS)
+      count++;
+  }
+  return count;
+}
+
+//
+// bitmap_open
+//
+struct BitmapIndex *bitmap_open(struct Database *db,
+                                struct TableMeta *tablemeta, int column) {
+  if (db == NULL)
+    panic("db is NULL (bitmap_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (bitmap_open)");
+
+  struct SidecarStamp stamp;
+  if (!sidecar_stamp(&stamp, db, tablemeta, BITMAP_MAGIC))
+    return NULL;
+
+  struct BitmapIndex *bitmap =
+      (struct BitmapIndex *)malloc(sizeof(struct BitmapIndex));
+  if (bitmap == NULL)
+    panic("out of memory");
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(bitmap->path, db, tablemeta, ext);
+
+  // the index must have been built from the current .data file:
+  bitmap->data = sidecar_map(bitmap->path, &stamp, &bitmap->size);
+  if (bitmap->data == NULL) { // no index yet, or stale
+    free(bitmap);
+    return NULL;
+  }
+
+  //
+  // ... and with the current meta-data:
+  //
+  const struct BitmapHeader *header = (const struct BitmapHeader *)bitmap->data;
+
+  bool valid = sizeof(struct BitmapHeader) <= bitmap->size &&
+               header->column == column &&
+               header->colType == tablemeta->columns[column].colType &&
+               header->numValues >= 0 &&
+               header->numValues <= BITMAP_MAX_VALUES &&
+               sizeof(struct BitmapHeader) +
+                       header->numValues * sizeof(struct BitmapValue) <=
+                   bitmap->size;
+
+  if (!valid) { // damaged, the caller will rebuild it
+    sidecar_unmap(bitmap->data, bitmap->size);
+    free(bitmap);
+    return NULL;
+  }
+
+  bitmap->column = column;
+  bitmap->lowCardinality = (header->lowCardinality != 0);
+  bitmap->numValues = header->numValues;
+
+  return bitmap;
+}
+
+//
+// bitmap_build
+//
+struct BitmapIndex *bitmap_build(struct Database *db,
+                                 struct TableMeta *tablemeta, int column,
+                                 struct ColumnCache *cache,
+                                 struct TableFile *tablefile) {
+  if (db == NULL)
+    panic("db is NULL (bitmap_build)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (bitmap_build)");
+  if (cache == NULL && tablefile == NULL)
+    panic("cache and tablefile are NULL (bitmap_build)");
+  if (tablemeta->columns[column].colType != COL_TYPE_STRING)
+    panic("only string columns have bitmap indexes (bitmap_build)");
+
+  struct BitmapHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!sidecar_stamp(&header.stamp, db, tablemeta, BITMAP_MAGIC))
+    return NULL;
+
+  int numRecords = (cache != NULL) ? cache->numRows : tablefile->numRecords;
+
+  //
+  // (1) one pass over the records, collecting the record #s of each
+  // distinct value; gives up once there are too many values:
+  //
+  struct Distinct *distinct = (struct Distinct *)malloc(
+      sizeof(struct Distinct) * (BITMAP_MAX_VALUES + 1));
+  bool *needed = (bool *)malloc(sizeof(bool) * tablemeta->numColumns);
+  struct FieldValue *values = (struct FieldValue *)malloc(
+      sizeof(struct FieldValue) * tablemeta->numColumns);
+  char *key = (char *)malloc(sizeof(char) * (tablemeta->recordSize + 1));
+  if (distinct == NULL || needed == NULL || values == NULL || key == NULL)
+    panic("out of memory");
+
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    needed[i] = (i == column);
+  }
+
+  struct RecordDecoder *decoder =
+      (cache == NULL) ? decoder_create(tablemeta, needed) : NULL;
+  int numValues = 0;
+  int last = 0; // the value of the previous record, a likely match
+
+  for (int r = 0; r < numRecords && numValues <= BITMAP_MAX_VALUES; r++) {
+    if (cache != NULL)
+      colcache_decode(cache, r, needed, values);
+    else
+      decoder_decode(decoder, tablefile_record(tablefile, r), values);
+
+    int len = values[column].value.str.len;
+    for (int i = 0; i < len; i++) {
+      key[i] = (char)tolower((unsigned char)values[column].value.str.s[i]);
+    }
+
+    int v = last;
+    if (v >= numValues || distinct[v].keyLength != len ||
+        memcmp(distinct[v].key, key, len) != 0) {
+      for (v = 0; v < numValues; v++) {
+        if (distinct[v].keyLength == len &&
+            memcmp(distinct[v].key, key, len) == 0)
+          break;
+      }
+    }
+
+    if (v == numValues) { // a new value
+      numValues++;
+      if (numValues > BITMAP_MAX_VALUES)
+        break;
+
+      distinct[v].key = (char *)malloc(sizeof(char) * (len + 1));
+      if (distinct[v].key == NULL)
+        panic("out of memory");
+      memcpy(distinct[v].key, key, len);
+      distinct[v].key[len] = '\0';
+      distinct[v].keyLength = len;
+      distinct[v].recNums = NULL;
+      distinct[v].numRecNums = 0;
+      distinct[v].capacity = 0;
+    }
+
+    struct Distinct *d = &distinct[v];
+    if (d->numRecNums == d->capacity) { // grow the list
+      d->capacity = (d->capacity == 0) ? 64 : d->capacity * 2;
+      d->recNums = (int *)realloc(d->recNums, sizeof(int) * d->capacity);
+      if (d->recNums == NULL)
+        panic("out of memory");
+    }
+    d->recNums[d->numRecNums] = r;
+    d->numRecNums++;
+    last = v;
+  }
+
+  decoder_destroy(decoder);
+  free(key);
+  free(values);
+  free(needed);
+
+  bool lowCardinality = (numValues <= BITMAP_MAX_VALUES);
+  if (!lowCardinality) // the last one was never filled in
+    numValues = BITMAP_MAX_VALUES;
+
+  //
+  // (2) lay out the file: the value headers, their containers, the
+  // values, then the container contents:
+  //
+  header.column = column;
+  header.colType = COL_TYPE_STRING;
+  header.lowCardinality = lowCardinality ? 1 : 0;
+  header.numValues = lowCardinality ? numValues : 0;
+
+  int numWritten = header.numValues;
+  uint64_t size = sizeof(struct BitmapHeader) +
+                  (uint64_t)numWritten * sizeof(struct BitmapValue);
+  for (int v = 0; v < numWritten; v++) {
+    size += (uint64_t)countContainers(distinct[v].recNums,
+                                      distinct[v].numRecNums) *
+            sizeof(struct BitmapContainer);
+  }
+  for (int v = 0; v < numWritten; v++) {
+    size += distinct[v].keyLength + 1;
+  }
+  size = align8(size);
+  uint64_t payloadStart = size;
+  for (int v = 0; v < numWritten; v++) {
+    const int *recNums = distinct[v].recNums;
+    int n = distinct[v].numRecNums;
+    for (int i = 0; i < n;) { // one container at a time
+      int chunk = recNums[i] / BITMAP_CHUNK_RECORDS;
+      int j = i;
+      while (j < n && recNums[j] / BITMAP_CHUNK_RECORDS == chunk)
+        j++;
+      size += (j - i <= BITMAP_MAX_ARRAY_SIZE)
+                  ? align8(sizeof(uint16_t) * (j - i))
+                  : sizeof(uint64_t) * BITMAP_WORDS;
+      i = j;
+    }
+  }
+
+  char *image = (char *)malloc(size);
+  if (image == NULL)
+    panic("out of memory");
+  memset(image, 0, size);
+  memcpy(image, &header, sizeof(header));
+
+  //
+  // (3) fill it in:
+  //
+  struct BitmapValue *valueHeaders =
+      (struct BitmapValue *)(image + sizeof(struct BitmapHeader));
+  uint64_t offset = sizeof(struct BitmapHeader) +
+                    (uint64_t)numWritten * sizeof(struct BitmapValue);
+  for (int v = 0; v < numWritten; v++) {
+    valueHeaders[v].containerOffset = offset;
+    valueHeaders[v].numContainers =
+        countContainers(distinct[v].recNums, distinct[v].numRecNums);
+    valueHeaders[v].cardinality = distinct[v].numRecNums;
+    offset += (uint64_t)valueHeaders[v].numContainers *
+              sizeof(struct BitmapContainer);
+  }
+  for (int v = 0; v < numWritten; v++) {
+    valueHeaders[v].keyOffset = offset;
+    valueHeaders[v].keyLength = distinct[v].keyLength;
+    memcpy(image + offset, distinct[v].key, distinct[v].keyLength + 1);
+    offset += distinct[v].keyLength + 1;
+  }
+
+  offset = payloadStart;
+  for (int v = 0; v < numWritten; v++) {
+    struct BitmapContainer *containers =
+        (struct BitmapContainer *)(image + valueHeaders[v].containerOffset);
+    const int *recNums = distinct[v].recNums;
+    int n = distinct[v].numRecNums;
+    int c = 0;
+
+    for (int i = 0; i < n; c++) {
+      int chunk = recNums[i] / BITMAP_CHUNK_RECORDS;
+      int j = i;
+      while (j < n && recNums[j] / BITMAP_CHUNK_RECORDS == chunk)
+        j++;
+
+      containers[c].chunk = chunk;
+      containers[c].cardinality = j - i;
+      containers[c].offset = offset;
+
+      if (j - i <= BITMAP_MAX_ARRAY_SIZE) {
+        uint16_t *array = (uint16_t *)(image + offset);
+        for (int k = i; k < j; k++) {
+          array[k - i] = (uint16_t)(recNums[k] % BITMAP_CHUNK_RECORDS);
+        }
+        offset += align8(sizeof(uint16_t) * (j - i));
+      } else {
+        uint64_t *words = (uint64_t *)(image + offset);
+        for (int k = i; k < j; k++) {
+          int bit = recNums[k] % BITMAP_CHUNK_RECORDS;
+          words[bit / 64] |= (uint64_t)1 << (bit % 64);
+        }
+        offset += sizeof(uint64_t) * BITMAP_WORDS;
+      }
+      i = j;
+    }
+  }
+
+  for (int v = 0; v < numValues; v++) {
+    free(distinct[v].key);
+    free(distinct[v].recNums);
+  }
+  free(distinct);
+
+  //
+  // (4) write to a temporary file and rename it into place:
+  //
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  char indexPath[SIDECAR_MAX_PATH];
+  char tempPath[SIDECAR_MAX_PATH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(indexPath, db, tablemeta, ext);
+
+  bool written = false;
+  FILE *file = sidecar_create(indexPath, tempPath, &header.stamp);
+  if (file != NULL) {
+    fwrite(image + sizeof(header.stamp), 1, size - sizeof(header.stamp), file);
+    written = sidecar_commit(file, tempPath, indexPath);
+  }
+
+  free(image);
+
+  if (!written)
+    return NULL;
+
+  return bitmap_open(db, tablemeta, column);
+}
+
+//
+// bitmap_close
+//
+void bitmap_close(struct BitmapIndex *bitmap) {
+  if (bitmap == NULL)
+    return;
+
+  sidecar_unmap(bitmap->data, bitmap->size);
+  free(bitmap);
+}
+
+//
+// bitmap_find
+//
+int bitmap_find(struct BitmapIndex *bitmap, char *value) {
+  for (int v = 0; v < bitmap->numValues; v++) {
+    const struct BitmapValue *bv = findValue(bitmap, v);
+    const char *key = bitmap->data + bv->keyOffset;
+
+    int i = 0;
+    while (i < bv->keyLength &&
+           tolower((unsigned char)value[i]) == (unsigned char)key[i])
+      i++;
+
+    if (i == bv->keyLength && value[i] == '\0')
+      return v;
+  }
+
+  return -1;
+}
+
+//
+// bitmap_count
+//
+int bitmap_count(struct BitmapIndex *bitmap, int valueNum) {
+  const struct BitmapValue *bv = findValue(bitmap, valueNum);
+  const struct BitmapContainer *containers = findContainers(bitmap, bv);
+
+  int count = 0;
+  for (int c = 0; c < bv->numContainers; c++) {
+    if (containers[c].cardinality <= BITMAP_MAX_ARRAY_SIZE) {
+      count += containers[c].cardinality;
+    } else {
+      const uint64_t *words =
+          (const uint64_t *)(bitmap->data + containers[c].offset);
+      for (int w = 0; w < BITMAP_WORDS; w++) {
+        count += __builtin_popcountll(words[w]);
+      }
+    }
+  }
+
+  return count;
+}
+
+//
+// bitmap_recNums
+//
+void bitmap_recNums(struct BitmapIndex *bitmap, int valueNum, int *recNums) {
+  const struct BitmapValue *bv = findValue(bitmap, valueNum);
+  const struct BitmapContainer *containers = findContainers(bitmap, bv);
+
+  int n = 0;
+  for (int c = 0; c < bv->numContainers; c++) {
+    int base = containers[c].chunk * BITMAP_CHUNK_RECORDS;
+
+    if (containers[c].cardinality <= BITMAP_MAX_ARRAY_SIZE) {
+      const uint16_t *array =
+          (const uint16_t *)(bitmap->data + containers[c].offset);
+      for (int i = 0; i < containers[c].cardinality; i++) {
+        recNums[n++] = base + array[i];
+      }
+    } else {
+      const uint64_t *words =
+          (const uint64_t *)(bitmap->data + containers[c].offset);
+      for (int w = 0; w < BITMAP_WORDS; w++) {
+        uint64_t word = words[w];
+        while (word != 0) { // one set bit at a time, lowest first
+          recNums[n++] = base + (w * 64) + __builtin_ctzll(word);
+          word &= word - 1;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,109 @@
+/*bitmap.h*/
+
+//
+// Project: Bitmap indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+
+#include "colcache.h"
+#include "database.h"
+#include "sidecar.h"
+#include "tablefile.h"
+
+//
+// A BitmapIndex is an index on one string column of a table with
+// only a few distinct values, e.g. Genres.Genre. For each distinct
+// value, it holds the set of record #s with that value, compressed
+// in the style of a roaring bitmap: the record #s are split into
+// chunks of 65536, and the chunk's record #s are stored either as a
+// sorted array of 16-bit offsets, if there are few of them, or as a
+// bitmap of 65536 bits. Values are compared ignoring case, just as
+// in a where clause, so "Comedy" and "comedy" share a bitmap.
+//
+// The index is stored next to the table as
+// "TABLE-NAME.COLUMN-NAME.bmap" and mapped into memory. If the
+// column turns out to have more than BITMAP_MAX_VALUES distinct
+// values, only that fact is stored, so it isn't tried again.
+//
+#define BITMAP_MAX_VALUES      256
+#define BITMAP_CHUNK_RECORDS   65536
+#define BITMAP_MAX_ARRAY_SIZE  4096  // a bigger set is stored as a bitmap
+
+struct BitmapIndex
+{
+  char        path[SIDECAR_MAX_PATH]; // name/name.column.bmap
+  const char* data;  // the mapped file
+  size_t      size;  // # of bytes in the file
+
+  int  column;          // index of the column in the table (0-based)
+  bool lowCardinality;  // false => too many distinct values, no bitmaps
+  int  numValues;       // # of distinct values, ignoring case
+};
+
+
+//
+// Functions:
+//
+
+//
+// bitmap_open
+//
+// Opens and maps the bitmap index on the given column of the table.
+// Returns NULL if there is none, or if it does not match the table's
+// current .data file or meta-data.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling bitmap_close().
+//
+struct BitmapIndex* bitmap_open(struct Database* db, struct TableMeta* tablemeta,
+  int column);
+
+//
+// bitmap_build
+//
+// Builds the bitmap index on the given string column of the table,
+// writes it, replacing any existing one, and then opens it. The
+// values are read from the columnar cache if there is one, otherwise
+// decoded from the table file. Returns NULL if the index could not
+// be written.
+//
+struct BitmapIndex* bitmap_build(struct Database* db, struct TableMeta* tablemeta,
+  int column, struct ColumnCache* cache, struct TableFile* tablefile);
+
+//
+// bitmap_close
+//
+// Unmaps the index and frees the memory associated with it.
+//
+void bitmap_close(struct BitmapIndex* bitmap);
+
+//
+// bitmap_find
+//
+// Returns the # (0-based) of the given value's bitmap, comparing
+// case-insensitively, or -1 if no record has the value.
+//
+int bitmap_find(struct BitmapIndex* bitmap, char* value);
+
+//
+// bitmap_count
+//
+// Returns the # of records in the given value's bitmap.
+//
+int bitmap_count(struct BitmapIndex* bitmap, int valueNum);
+
+//
+// bitmap_recNums
+//
+// Copies the record #s in the given value's bitmap into recNums,
+// in record order; there are bitmap_count() of them.
+//
+void bitmap_recNums(struct BitmapIndex* bitmap, int valueNum, int* recNums);
@@ -0,0 +1,573 @@
+/*btree.c*/
+
+//
+// Project: B+tree indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int32_t
+#include <stdio.h>
+#include <stdlib.h> // qsort
+#include <string.h> // memcpy, memset, strcpy, strcat
+
+#include "btree.h"
+#include "colcache.h"
+#include "database.h"
+#include "decoder.h"
+#include "options.h"
+#include "sidecar.h"
+#include "tablefile.h"
+#include "util.h"
+
+#define BTREE_MAGIC "SSQLBTR2"
+
+//
+// On-disk layout: page 0 holds the BTreeHeader; pages 1..numLeaves
+// are the leaves, in key order; the internal pages follow, one level
+// at a time from the bottom up, so the root is the last page. Every
+// page starts with a PageHeader, followed by an array of
+// BTREE_FANOUT keys and an array of BTREE_FANOUT values: record #s
+// in a leaf, child page #s in an internal page. The key of a child
+// is the smallest key in its subtree.
+//
+// Page 0 also lists the INCLUDE columns, right after the header. Their
+// values follow the last page: for each included column, one int32_t
+// or double per entry, in entry order, padded to a multiple of 8 bytes.
+//
+struct BTreeHeader
+{
+  struct SidecarStamp stamp;  // the .data file the index was built from
+  int32_t             column;
+  int32_t             colType;
+  int32_t             numEntries;
+  int32_t             rootPage;
+  int32_t             firstLeaf;
+  int32_t             height;
+  int32_t             pageSize;  // BTREE_PAGE_SIZE at the time
+  int32_t             numIncluded;
+};
+
+struct PageHeader
+{
+  int32_t level;    // 0 => leaf
+  int32_t numKeys;
+  int32_t unused[2];
+};
+
+#define BTREE_FANOUT                                                           \
+  ((int)((BTREE_PAGE_SIZE - sizeof(struct PageHeader)) / (2 * sizeof(int32_t))))
+
+// one key and the record that holds it, while building
+struct Entry
+{
+  int32_t key;
+  int32_t recNum;
+};
+
+// builds ".COLUMN-NAME.idx", the extension of the index's sidecar
+static void buildExtension(char *ext, struct TableMeta *tablemeta, int column) {
+  strcpy(ext, ".");
+  strcat(ext, tablemeta->columns[column].name);
+  strcat(ext, ".idx");
+}
+
+// returns the page header, keys and values of the given page
+static const struct PageHeader *pageHeader(const char *data, int page) {
+  return (const struct PageHeader *)(data + ((size_t)page * BTREE_PAGE_SIZE));
+}
+
+static const int32_t *pageKeys(const char *data, int page) {
+  return (const int32_t *)(data + ((size_t)page * BTREE_PAGE_SIZE) +
+                           sizeof(struct PageHeader));
+}
+
+static const int32_t *pageValues(const char *data, int page) {
+  return pageKeys(data, page) + BTREE_FANOUT;
+}
+
+// finds the INCLUDE columns of an index on the given column: if
+// covering indexes are enabled, the table's other int and real
+// columns, in table order, skipping any that would take the index
+// past BTREE_MAX_INCLUDED columns or BTREE_MAX_INCLUDED_BYTES bytes
+// per entry. Returns their #, and their indices via included
+static int findIncluded(struct TableMeta *tablemeta, int column,
+                        int32_t *included) {
+  int numIncluded = 0;
+  size_t bytes = 0;
+  if (!options_get()->useCoveringIndexes)
+    return 0;
+
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    int colType = tablemeta->columns[i].colType;
+    if (i == column || (colType != COL_TYPE_INT && colType != COL_TYPE_REAL))
+      continue;
+
+    size_t width =
+        (colType == COL_TYPE_REAL) ? sizeof(double) : sizeof(int32_t);
+    if (numIncluded < BTREE_MAX_INCLUDED &&
+        bytes + width <= BTREE_MAX_INCLUDED_BYTES) {
+      included[numIncluded] = i;
+      numIncluded++;
+      bytes += width;
+    }
+  }
+  return numIncluded;
+}
+
+// returns the # of bytes of an included column's values, padded
+static size_t includedSize(int colType, int numEntries) {
+  size_t width = (colType == COL_TYPE_REAL) ? sizeof(double) : sizeof(int32_t);
+  return ((width * numEntries) + 7) & ~(size_t)7;
+}
+
+// returns the # of keys that are < key, or <= key if orEqual is true
+static int countBelow(const int32_t *keys, int numKeys, int key, bool orEqual) {
+  int lo = 0;
+  int hi = numKeys;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (keys[mid] < key || (orEqual && keys[mid] == key))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// descends from the root to the leaf where the entries >= key (or
+// > key, if upper is true) begin, and returns the # of the first one
+static int findEntry(struct BTree *btree, int key, bool upper) {
+  int page = btree->rootPage;
+
+  for (int level = btree->height - 1; level > 0; level--) {
+    const struct PageHeader *header = pageHeader(btree->data, page);
+    int n = countBelow(pageKeys(btree->data, page), header->numKeys, key,
+                       upper);
+
+    // the wanted entries can start in the last child that begins with
+    // a smaller key, since it may also hold larger ones
+    page = pageValues(btree->data, page)[(n > 0) ? n - 1 : 0];
+  }
+
+  const struct PageHeader *header = pageHeader(btree->data, page);
+  int n = countBelow(pageKeys(btree->data, page), header->numKeys, key, upper);
+
+  // every leaf but the last is full
+  return ((page - btree->firstLeaf) * BTREE_FANOUT) + n;
+}
+
+// orders entries by key, and entries with the same key by record #
+static int compareEntries(const void *a, const void *b) {
+  const struct Entry *e1 = (const struct Entry *)a;
+  const struct Entry *e2 = (const struct Entry *)b;
+
+  if (e1->key != e2->key)
+    return (e1->key < e2->key) ? -1 : 1;
+  return (e1->recNum < e2->recNum) ? -1 : (e1->recNum > e2->recNum);
+}
+
+//
+// btree_open
+//
+struct BTree *btree_open(struct Database *db, struct TableMeta *tablemeta,
+                         int column) {
+  if (db == NULL)
+    panic("db is NULL (btree_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (btree_open)");
+
+  struct SidecarStamp stamp;
+  if (!sidecar_stamp(&stamp, db, tablemeta, BTREE_MAGIC))
+    return NULL;
+
+  struct BTree *btree = (struct BTree *)malloc(sizeof(struct BTree));
+  if (btree == NULL)
+    panic("out of memory");
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(btree->path, db, tablemeta, ext);
+
+  // the index must have been built from the current .data file:
+  btree->data = sidecar_map(btree->path, &stamp, &btree->size);
+  if (btree->data == NULL) { // no index yet, or stale
+    free(btree);
+    return NULL;
+  }
+
+  //
+  // ... and with the current meta-data and page size:
+  //
+  const struct BTreeHeader *header = (const struct BTreeHeader *)btree->data;
+  size_t numPages = btree->size / BTREE_PAGE_SIZE;
+
+  bool valid = numPages >= 2 && header->pageSize == BTREE_PAGE_SIZE &&
+               header->column == column &&
+               header->colType == tablemeta->columns[column].colType &&
+               header->numEntries == header->stamp.numRecords &&
+               header->firstLeaf == 1 && header->rootPage >= 1 &&
+               (size_t)header->rootPage < numPages && header->height >= 1;
+
+  if (!valid) { // damaged, the caller will rebuild it
+    sidecar_unmap(btree->data, btree->size);
+    free(btree);
+    return NULL;
+  }
+
+  //
+  // ... with the INCLUDE columns it should have, whose values start
+  // right after the root:
+  //
+  const int32_t *included =
+      (const int32_t *)(btree->data + sizeof(struct BTreeHeader));
+  int32_t expected[BTREE_MAX_INCLUDED];
+  size_t offset = (size_t)(header->rootPage + 1) * BTREE_PAGE_SIZE;
+
+  valid = (header->numIncluded == findIncluded(tablemeta, column, expected));
+  for (int i = 0; valid && i < header->numIncluded; i++) {
+    int c = expected[i];
+    valid = (included[i] == c);
+    btree->included[i] = c;
+    btree->includedTypes[i] = tablemeta->columns[c].colType;
+    btree->includedValues[i] = btree->data + offset;
+    offset += includedSize(btree->includedTypes[i], header->numEntries);
+  }
+
+  if (!valid || offset > btree->size) { // built otherwise, or damaged
+    sidecar_unmap(btree->data, btree->size);
+    free(btree);
+    return NULL;
+  }
+
+  btree->column = column;
+  btree->numEntries = header->numEntries;
+  btree->rootPage = header->rootPage;
+  btree->firstLeaf = header->firstLeaf;
+  btree->height = header->height;
+  btree->numIncluded = header->numIncluded;
+
+  return btree;
+}
+
+//
+// btree_build
+//
+struct BTree *btree_build(struct Database *db, struct TableMeta *tablemeta,
+                          int column, struct ColumnCache *cache,
+                          struct TableFile *tablefile) {
+  if (db == NULL)
+    panic("db is NULL (btree_build)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (btree_build)");
+  if (cache == NULL && tablefile == NULL)
+    panic("cache and tablefile are NULL (btree_build)");
+  if (tablemeta->columns[column].colType != COL_TYPE_INT)
+    panic("only int columns can be indexed (btree_build)");
+
+  struct BTreeHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!sidecar_stamp(&header.stamp, db, tablemeta, BTREE_MAGIC))
+    return NULL;
+
+  int numEntries = (cache != NULL) ? cache->numRows : tablefile->numRecords;
+
+  //
+  // (1) collect the key of every record, and sort them:
+  //
+  struct Entry *entries =
+      (struct Entry *)malloc(sizeof(struct Entry) * numEntries + 1);
+  bool *needed = (bool *)malloc(sizeof(bool) * tablemeta->numColumns);
+  struct FieldValue *values = (struct FieldValue *)malloc(
+      sizeof(struct FieldValue) * tablemeta->numColumns);
+  if (entries == NULL || needed == NULL || values == NULL)
+    panic("out of memory");
+
+  //
+  // the values of the INCLUDE columns are collected by record # (ints
+  // are exact as doubles), and laid out in entry order once the
+  // entries are sorted:
+  //
+  int32_t included[BTREE_MAX_INCLUDED];
+  double *recordValues[BTREE_MAX_INCLUDED];
+  int numIncluded = findIncluded(tablemeta, column, included);
+
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    needed[i] = (i == column);
+  }
+  for (int k = 0; k < numIncluded; k++) {
+    needed[included[k]] = true;
+    recordValues[k] = (double *)malloc(sizeof(double) * numEntries + 1);
+    if (recordValues[k] == NULL)
+      panic("out of memory");
+  }
+
+  struct RecordDecoder *decoder =
+      (cache == NULL) ? decoder_create(tablemeta, needed) : NULL;
+
+  for (int r = 0; r < numEntries; r++) {
+    if (cache != NULL)
+      colcache_decode(cache, r, needed, values);
+    else
+      decoder_decode(decoder, tablefile_record(tablefile, r), values);
+
+    entries[r].key = values[column].value.i;
+    entries[r].recNum = r;
+
+    for (int k = 0; k < numIncluded; k++) {
+      struct FieldValue *value = &values[included[k]];
+      recordValues[k][r] = (value->valueType == COL_TYPE_INT) ? value->value.i
+                                                              : value->value.r;
+    }
+  }
+
+  decoder_destroy(decoder);
+  free(values);
+  free(needed);
+
+  qsort(entries, numEntries, sizeof(struct Entry), compareEntries);
+
+  //
+  // (2) count the pages: the header, the leaves, then each level of
+  // internal pages until one page --- the root --- holds them all:
+  //
+  int numLeaves = (numEntries + BTREE_FANOUT - 1) / BTREE_FANOUT;
+  if (numLeaves < 1) // an empty table still has a (leaf) root
+    numLeaves = 1;
+
+  int numPages = 1 + numLeaves;
+  int height = 1;
+  for (int n = numLeaves; n > 1; n = (n + BTREE_FANOUT - 1) / BTREE_FANOUT) {
+    numPages += (n + BTREE_FANOUT - 1) / BTREE_FANOUT;
+    height++;
+  }
+
+  char *image = (char *)malloc((size_t)numPages * BTREE_PAGE_SIZE);
+  if (image == NULL)
+    panic("out of memory");
+  memset(image, 0, (size_t)numPages * BTREE_PAGE_SIZE);
+
+  //
+  // (3) fill the leaves, then build each level from the one below:
+  //
+  for (int leaf = 0; leaf < numLeaves; leaf++) {
+    int page = 1 + leaf;
+    struct PageHeader *ph =
+        (struct PageHeader *)pageHeader(image, page);
+    int32_t *keys = (int32_t *)pageKeys(image, page);
+    int32_t *recNums = (int32_t *)pageValues(image, page);
+
+    int first = leaf * BTREE_FANOUT;
+    int n = numEntries - first;
+    if (n > BTREE_FANOUT)
+      n = BTREE_FANOUT;
+
+    ph->level = 0;
+    ph->numKeys = n;
+    for (int i = 0; i < n; i++) {
+      keys[i] = entries[first + i].key;
+      recNums[i] = entries[first + i].recNum;
+    }
+  }
+
+  int levelStart = 1; // the page # of the first page of the level below
+  int levelCount = numLeaves;
+  int nextPage = 1 + numLeaves;
+  for (int level = 1; level < height; level++) {
+    int count = (levelCount + BTREE_FANOUT - 1) / BTREE_FANOUT;
+
+    for (int p = 0; p < count; p++) {
+      int page = nextPage + p;
+      struct PageHeader *ph = (struct PageHeader *)pageHeader(image, page);
+      int32_t *keys = (int32_t *)pageKeys(image, page);
+      int32_t *children = (int32_t *)pageValues(image, page);
+
+      int first = p * BTREE_FANOUT;
+      int n = levelCount - first;
+      if (n > BTREE_FANOUT)
+        n = BTREE_FANOUT;
+
+      ph->level = level;
+      ph->numKeys = n;
+      for (int i = 0; i < n; i++) {
+        int child = levelStart + first + i;
+        children[i] = child;
+        keys[i] = pageKeys(image, child)[0];
+      }
+    }
+
+    levelStart = nextPage;
+    levelCount = count;
+    nextPage += count;
+  }
+
+  //
+  // (4) lay out the included columns' values in entry order:
+  //
+  size_t includedBytes = 0;
+  for (int k = 0; k < numIncluded; k++) {
+    includedBytes +=
+        includedSize(tablemeta->columns[included[k]].colType, numEntries);
+  }
+
+  char *includedImage = (char *)malloc(includedBytes + 1);
+  if (includedImage == NULL)
+    panic("out of memory");
+  memset(includedImage, 0, includedBytes);
+
+  size_t offset = 0;
+  for (int k = 0; k < numIncluded; k++) {
+    int colType = tablemeta->columns[included[k]].colType;
+
+    if (colType == COL_TYPE_INT) {
+      int32_t *out = (int32_t *)(includedImage + offset);
+      for (int e = 0; e < numEntries; e++) {
+        out[e] = (int32_t)recordValues[k][entries[e].recNum];
+      }
+    } else {
+      double *out = (double *)(includedImage + offset);
+      for (int e = 0; e < numEntries; e++) {
+        out[e] = recordValues[k][entries[e].recNum];
+      }
+    }
+
+    offset += includedSize(colType, numEntries);
+    free(recordValues[k]);
+  }
+
+  free(entries);
+
+  //
+  // (5) fill in the header page, and write the image, followed by the
+  // included columns, to a temporary file which is renamed into place:
+  //
+  header.stamp.numRecords = numEntries;
+  header.column = column;
+  header.colType = COL_TYPE_INT;
+  header.numEntries = numEntries;
+  header.rootPage = numPages - 1;
+  header.firstLeaf = 1;
+  header.height = height;
+  header.pageSize = BTREE_PAGE_SIZE;
+  header.numIncluded = numIncluded;
+  memcpy(image, &header, sizeof(header));
+  memcpy(image + sizeof(header), included, sizeof(int32_t) * numIncluded);
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  char indexPath[SIDECAR_MAX_PATH];
+  char tempPath[SIDECAR_MAX_PATH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(indexPath, db, tablemeta, ext);
+
+  bool written = false;
+  FILE *file = sidecar_create(indexPath, tempPath, &header.stamp);
+  if (file != NULL) {
+    fwrite(image + sizeof(header.stamp), 1,
+           ((size_t)numPages * BTREE_PAGE_SIZE) - sizeof(header.stamp), file);
+    fwrite(includedImage, 1, includedBytes, file);
+    written = sidecar_commit(file, tempPath, indexPath);
+  }
+
+  free(image);
+  free(includedImage);
+
+  if (!written)
+    return NULL;
+
+  return btree_open(db, tablemeta, column);
+}
+
+//
+// btree_close
+//
+void btree_close(struct BTree *btree) {
+  if (btree == NULL)
+    return;
+
+  sidecar_unmap(btree->data, btree->size);
+  free(btree);
+}
+
+//
+// btree_lowerBound
+//
+int btree_lowerBound(struct BTree *btree, int key) {
+  return findEntry(btree, key, false);
+}
+
+//
+// btree_upperBound
+//
+int btree_upperBound(struct BTree *btree, int key) {
+  return findEntry(btree, key, true);
+}
+
+//
+// btree_key
+//
+int btree_key(struct BTree *btree, int entry) {
+  int page = btree->firstLeaf + (entry / BTREE_FANOUT);
+  return pageKeys(btree->data, page)[entry % BTREE_FANOUT];
+}
+
+//
+// btree_recNums
+//
+void btree_recNums(struct BTree *btree, int first, int last, int *recNums) {
+  int e = first;
+  while (e < last) { // one leaf at a time
+    int page = btree->firstLeaf + (e / BTREE_FANOUT);
+    int pos = e % BTREE_FANOUT;
+    int n = BTREE_FANOUT - pos;
+    if (n > last - e)
+      n = last - e;
+
+    memcpy(recNums + (e - first), pageValues(btree->data, page) + pos,
+           sizeof(int32_t) * n);
+    e += n;
+  }
+}
+
+//
+// btree_covers
+//
+bool btree_covers(struct BTree *btree, const bool *needed, int numColumns) {
+  for (int i = 0; i < numColumns; i++) {
+    if (!needed[i] || i == btree->column)
+      continue;
+
+    bool found = false;
+    for (int k = 0; k < btree->numIncluded && !found; k++) {
+      found = (btree->included[k] == i);
+    }
+    if (!found)
+      return false;
+  }
+  return true;
+}
+
+//
+// btree_decode
+//
+void btree_decode(struct BTree *btree, int entry, const bool *needed,
+                  struct FieldValue *values) {
+  if (needed[btree->column]) {
+    values[btree->column].value.i = btree_key(btree, entry);
+    values[btree->column].valueType = COL_TYPE_INT;
+  }
+
+  for (int k = 0; k < btree->numIncluded; k++) {
+    int c = btree->included[k];
+    if (!needed[c])
+      continue;
+
+    if (btree->includedTypes[k] == COL_TYPE_INT)
+      values[c].value.i = ((const int32_t *)btree->includedValues[k])[entry];
+    else
+      values[c].value.r = ((const double *)btree->includedValues[k])[entry];
+    values[c].valueType = btree->includedTypes[k];
+  }
+}
@@ -0,0 +1,153 @@
+/*btree.h*/
+
+//
+// Project: B+tree indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+
+#include "colcache.h"
+#include "database.h"
+#include "decoder.h"
+#include "sidecar.h"
+#include "tablefile.h"
+
+//
+// A BTree is a B+tree index on one int column of a table that the
+// meta-data marks as indexed (or unique-indexed), mapping each key
+// to the # of the record that holds it. It is stored next to the
+// table as "TABLE-NAME.COLUMN-NAME.idx", in pages of BTREE_PAGE_SIZE
+// bytes, and mapped into memory, so a lookup touches one page per
+// level of the tree --- 2 or 3 pages even for large tables.
+//
+// The tree is bulk-loaded from the sorted entries, so every leaf but
+// the last is full, and entries with the same key are in record
+// order. Entries are thus numbered 0..numEntries-1 in key order,
+// and a range of keys is a range of entry #s.
+//
+// A B+tree can also be a covering index: its entries then carry the
+// values of INCLUDE columns, stored after the pages, one array per
+// column in entry order. A query that only refers to the key and
+// included columns is then answered from the index alone, without
+// reading a single record of the table. So the index stays small,
+// each one includes at most BTREE_MAX_INCLUDED of the table's other
+// int and real columns, and at most BTREE_MAX_INCLUDED_BYTES of
+// values per entry; which ones is recorded in the index's header.
+//
+#define BTREE_PAGE_SIZE          4096
+#define BTREE_MAX_INCLUDED       4
+#define BTREE_MAX_INCLUDED_BYTES 16
+
+struct BTree
+{
+  char        path[SIDECAR_MAX_PATH]; // name/name.column.idx
+  const char* data;  // the mapped file
+  size_t      size;  // # of bytes in the file
+
+  int column;      // index of the column in the table (0-based)
+  int numEntries;  // one per record
+  int rootPage;    // page # of the root; pages are numbered from 0
+  int firstLeaf;   // page # of the first leaf; the leaves are contiguous
+  int height;      // # of levels, including the leaves
+
+  int         numIncluded;                      // # of INCLUDE columns
+  int         included[BTREE_MAX_INCLUDED];     // their indices in the table
+  int         includedTypes[BTREE_MAX_INCLUDED];
+  const char* includedValues[BTREE_MAX_INCLUDED]; // int or double ARRAYs
+};
+
+
+//
+// Functions:
+//
+
+//
+// btree_open
+//
+// Opens and maps the index on the given column of the table. Returns
+// NULL if there is none, or if it does not match the table's current
+// .data file or meta-data, or was built with other INCLUDE columns
+// than it should have now.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling btree_close().
+//
+struct BTree* btree_open(struct Database* db, struct TableMeta* tablemeta,
+  int column);
+
+//
+// btree_build
+//
+// Builds the index on the given int column of the table, writes it,
+// replacing any existing one, and then opens it. Unless covering
+// indexes are disabled, the table's other int and real columns are
+// included, in table order, as long as they fit within the limits.
+// The keys are read from the columnar cache if there is one,
+// otherwise decoded from the table file. Returns NULL if the index
+// could not be written.
+//
+struct BTree* btree_build(struct Database* db, struct TableMeta* tablemeta,
+  int column, struct ColumnCache* cache, struct TableFile* tablefile);
+
+//
+// btree_close
+//
+// Unmaps the index and frees the memory associated with it.
+//
+void btree_close(struct BTree* btree);
+
+//
+// btree_lowerBound
+//
+// Returns the # of the first entry whose key is >= key, or
+// numEntries if there is none.
+//
+int btree_lowerBound(struct BTree* btree, int key);
+
+//
+// btree_upperBound
+//
+// Returns the # of the first entry whose key is > key, or
+// numEntries if there is none.
+//
+int btree_upperBound(struct BTree* btree, int key);
+
+//
+// btree_key
+//
+// Returns the key of the given entry, where 0 <= entry < numEntries.
+//
+int btree_key(struct BTree* btree, int entry);
+
+//
+// btree_recNums
+//
+// Copies the record #s of entries [first, last) into recNums, in
+// key order.
+//
+void btree_recNums(struct BTree* btree, int first, int last, int* recNums);
+
+//
+// btree_covers
+//
+// Returns true if every needed column of the table is either the
+// index's key or one of its INCLUDE columns.
+//
+bool btree_covers(struct BTree* btree, const bool* needed, int numColumns);
+
+//
+// btree_decode
+//
+// Fills in values[i] for each needed column i of the given entry,
+// just like colcache_decode() does for a row; the index must cover
+// the needed columns.
+//
+void btree_decode(struct BTree* btree, int entry, const bool* needed,
+  struct FieldValue* values);
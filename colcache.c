@@ -0,0 +1,352 @@
+/*colcache.c*/
+
+//
+// Project: Columnar cache of table data for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#define _DEFAULT_SOURCE // madvise under -std=c11
+
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int32_t, uint64_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>   // memcpy, memset
+#include <sys/mman.h> // madvise
+
+#include "colcache.h"
+#include "database.h"
+#include "decoder.h"
+#include "sidecar.h"
+#include "tablefile.h"
+#include "util.h"
+
+#define CACHE_MAGIC "SSQLCOL1"
+
+//
+// On-disk layout: a CacheHeader, followed by one CacheColumnHeader
+// per column, followed by the column segments, each starting on an
+// 8-byte boundary. Offsets are from the start of the file.
+//
+struct CacheHeader
+{
+  struct SidecarStamp stamp;  // the .data file the cache was built from
+  int32_t             numColumns;
+  int32_t             unused;
+};
+
+struct CacheColumnHeader
+{
+  int32_t  colType;
+  int32_t  unused;
+  uint64_t offset;      // the int32_t/double array, or the string offsets
+  uint64_t blobOffset;  // strings only: the blob
+  uint64_t blobSize;    // strings only: # of bytes in the blob
+};
+
+// rounds n up to the next multiple of 8
+static uint64_t align8(uint64_t n) { return (n + 7) & ~(uint64_t)7; }
+
+//
+// colcache_open
+//
+struct ColumnCache *colcache_open(struct Database *db,
+                                  struct TableMeta *tablemeta) {
+  if (db == NULL)
+    panic("db is NULL (colcache_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (colcache_open)");
+
+  struct SidecarStamp stamp;
+  if (!sidecar_stamp(&stamp, db, tablemeta, CACHE_MAGIC))
+    return NULL;
+
+  struct ColumnCache *cache =
+      (struct ColumnCache *)malloc(sizeof(struct ColumnCache));
+  if (cache == NULL)
+    panic("out of memory");
+
+  sidecar_path(cache->path, db, tablemeta, ".col");
+
+  // the cache must have been built from the current .data file:
+  cache->data = sidecar_map(cache->path, &stamp, &cache->size);
+  if (cache->data == NULL) { // no cache yet, or stale
+    free(cache);
+    return NULL;
+  }
+
+  //
+  // ... and with the current meta-data:
+  //
+  const struct CacheHeader *header = (const struct CacheHeader *)cache->data;
+  const struct CacheColumnHeader *colHeaders =
+      (const struct CacheColumnHeader *)(cache->data +
+                                         sizeof(struct CacheHeader));
+  int numRows = header->stamp.numRecords;
+
+  bool valid = sizeof(struct CacheHeader) <= cache->size &&
+               header->numColumns == tablemeta->numColumns &&
+               sizeof(struct CacheHeader) +
+                       header->numColumns * sizeof(struct CacheColumnHeader) <=
+                   cache->size;
+
+  for (int i = 0; valid && i < tablemeta->numColumns; i++) {
+    const struct CacheColumnHeader *ch = &colHeaders[i];
+    uint64_t elemSize = (ch->colType == COL_TYPE_INT) ? sizeof(int32_t)
+                        : (ch->colType == COL_TYPE_REAL) ? sizeof(double)
+                                                         : sizeof(uint64_t);
+    uint64_t numElems = (ch->colType == COL_TYPE_STRING)
+                            ? (uint64_t)numRows + 1
+                            : (uint64_t)numRows;
+
+    valid = ch->colType == tablemeta->columns[i].colType &&
+            ch->offset + (numElems * elemSize) <= cache->size &&
+            ch->blobOffset + ch->blobSize <= cache->size;
+  }
+
+  if (!valid) { // damaged, the caller will rebuild it
+    sidecar_unmap(cache->data, cache->size);
+    free(cache);
+    return NULL;
+  }
+
+  //
+  // point the columns into the mapping:
+  //
+  cache->numRows = numRows;
+  cache->numColumns = header->numColumns;
+  cache->columns = (struct CacheColumn *)malloc(sizeof(struct CacheColumn) *
+                                                cache->numColumns);
+  if (cache->columns == NULL)
+    panic("out of memory");
+
+  for (int i = 0; i < cache->numColumns; i++) {
+    const struct CacheColumnHeader *ch = &colHeaders[i];
+    struct CacheColumn *col = &cache->columns[i];
+
+    col->colType = ch->colType;
+    col->ints = NULL;
+    col->reals = NULL;
+    col->offsets = NULL;
+    col->blob = NULL;
+
+    if (ch->colType == COL_TYPE_INT)
+      col->ints = (const int32_t *)(cache->data + ch->offset);
+    else if (ch->colType == COL_TYPE_REAL)
+      col->reals = (const double *)(cache->data + ch->offset);
+    else {
+      col->offsets = (const uint64_t *)(cache->data + ch->offset);
+      col->blob = cache->data + ch->blobOffset;
+    }
+  }
+
+  madvise((void *)cache->data, cache->size, MADV_SEQUENTIAL);
+  return cache;
+}
+
+//
+// colcache_build
+//
+struct ColumnCache *colcache_build(struct Database *db,
+                                   struct TableMeta *tablemeta,
+                                   struct TableFile *tablefile) {
+  if (db == NULL)
+    panic("db is NULL (colcache_build)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (colcache_build)");
+  if (tablefile == NULL)
+    panic("tablefile is NULL (colcache_build)");
+
+  // the cache records which version of the .data file it came from
+  struct CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!sidecar_stamp(&header.stamp, db, tablemeta, CACHE_MAGIC))
+    return NULL;
+
+  int numRows = tablefile->numRecords;
+  int numColumns = tablemeta->numColumns;
+
+  //
+  // (1) decode every record into one array per column; strings are
+  // appended to a growing blob, each with a null terminator:
+  //
+  void **arrays = (void **)malloc(sizeof(void *) * numColumns);
+  char **blobs = (char **)malloc(sizeof(char *) * numColumns);
+  uint64_t *blobSizes = (uint64_t *)malloc(sizeof(uint64_t) * numColumns);
+  uint64_t *blobCapacities = (uint64_t *)malloc(sizeof(uint64_t) * numColumns);
+  if (arrays == NULL || blobs == NULL || blobSizes == NULL ||
+      blobCapacities == NULL)
+    panic("out of memory");
+
+  for (int i = 0; i < numColumns; i++) {
+    int colType = tablemeta->columns[i].colType;
+    size_t elemSize = (colType == COL_TYPE_INT)    ? sizeof(int32_t)
+                      : (colType == COL_TYPE_REAL) ? sizeof(double)
+                                                   : sizeof(uint64_t);
+    size_t numElems =
+        (colType == COL_TYPE_STRING) ? (size_t)numRows + 1 : (size_t)numRows;
+
+    arrays[i] = malloc(elemSize * numElems + 1); // +1 so 0 rows isn't NULL
+    blobs[i] = NULL;
+    blobSizes[i] = 0;
+    blobCapacities[i] = 0;
+    if (arrays[i] == NULL)
+      panic("out of memory");
+  }
+
+  struct RecordDecoder *decoder = decoder_create(tablemeta, NULL);
+  struct FieldValue *values =
+      (struct FieldValue *)malloc(sizeof(struct FieldValue) * numColumns);
+  if (values == NULL)
+    panic("out of memory");
+
+  for (int r = 0; r < numRows; r++) {
+    decoder_decode(decoder, tablefile_record(tablefile, r), values);
+
+    for (int i = 0; i < numColumns; i++) {
+      if (values[i].valueType == COL_TYPE_INT) {
+        ((int32_t *)arrays[i])[r] = values[i].value.i;
+      } else if (values[i].valueType == COL_TYPE_REAL) {
+        ((double *)arrays[i])[r] = values[i].value.r;
+      } else {
+        uint64_t len = values[i].value.str.len;
+        if (blobSizes[i] + len + 1 > blobCapacities[i]) { // grow the blob
+          blobCapacities[i] = (blobCapacities[i] + len + 1) * 2;
+          blobs[i] = (char *)realloc(blobs[i], blobCapacities[i]);
+          if (blobs[i] == NULL)
+            panic("out of memory");
+        }
+        ((uint64_t *)arrays[i])[r] = blobSizes[i];
+        memcpy(blobs[i] + blobSizes[i], values[i].value.str.s, len);
+        blobs[i][blobSizes[i] + len] = '\0';
+        blobSizes[i] += len + 1;
+      }
+    }
+  }
+
+  free(values);
+  decoder_destroy(decoder);
+
+  //
+  // (2) lay out the file: header, column headers, then the segments:
+  //
+  header.stamp.numRecords = numRows;
+  header.numColumns = numColumns;
+
+  struct CacheColumnHeader *colHeaders = (struct CacheColumnHeader *)malloc(
+      sizeof(struct CacheColumnHeader) * numColumns);
+  uint64_t *arraySizes = (uint64_t *)malloc(sizeof(uint64_t) * numColumns);
+  if (colHeaders == NULL || arraySizes == NULL)
+    panic("out of memory");
+
+  uint64_t offset = sizeof(struct CacheHeader) +
+                    (uint64_t)numColumns * sizeof(struct CacheColumnHeader);
+  for (int i = 0; i < numColumns; i++) {
+    int colType = tablemeta->columns[i].colType;
+    memset(&colHeaders[i], 0, sizeof(struct CacheColumnHeader));
+    colHeaders[i].colType = colType;
+
+    if (colType == COL_TYPE_INT)
+      arraySizes[i] = (uint64_t)numRows * sizeof(int32_t);
+    else if (colType == COL_TYPE_REAL)
+      arraySizes[i] = (uint64_t)numRows * sizeof(double);
+    else {
+      ((uint64_t *)arrays[i])[numRows] = blobSizes[i]; // end of the last one
+      arraySizes[i] = ((uint64_t)numRows + 1) * sizeof(uint64_t);
+    }
+
+    offset = align8(offset);
+    colHeaders[i].offset = offset;
+    offset += arraySizes[i];
+
+    if (colType == COL_TYPE_STRING) {
+      offset = align8(offset);
+      colHeaders[i].blobOffset = offset;
+      colHeaders[i].blobSize = blobSizes[i];
+      offset += blobSizes[i];
+    }
+  }
+
+  //
+  // (3) write to a temporary file and rename it into place, so a
+  // reader never sees a partially written cache:
+  //
+  char cachePath[SIDECAR_MAX_PATH];
+  char tempPath[SIDECAR_MAX_PATH + 16];
+  sidecar_path(cachePath, db, tablemeta, ".col");
+
+  bool written = false;
+  FILE *file = sidecar_create(cachePath, tempPath, &header.stamp);
+  if (file != NULL) {
+    fwrite(&header.numColumns, sizeof(header) - sizeof(header.stamp), 1, file);
+    fwrite(colHeaders, sizeof(struct CacheColumnHeader), numColumns, file);
+
+    for (int i = 0; i < numColumns; i++) {
+      sidecar_pad(file); // the offsets were laid out 8-byte aligned
+      fwrite(arrays[i], 1, arraySizes[i], file);
+
+      if (colHeaders[i].colType == COL_TYPE_STRING) {
+        sidecar_pad(file);
+        if (blobSizes[i] > 0)
+          fwrite(blobs[i], 1, blobSizes[i], file);
+      }
+    }
+
+    written = sidecar_commit(file, tempPath, cachePath);
+  }
+
+  for (int i = 0; i < numColumns; i++) {
+    free(arrays[i]);
+    free(blobs[i]);
+  }
+  free(arrays);
+  free(blobs);
+  free(blobSizes);
+  free(blobCapacities);
+  free(arraySizes);
+  free(colHeaders);
+
+  if (!written)
+    return NULL;
+
+  return colcache_open(db, tablemeta);
+}
+
+//
+// colcache_close
+//
+void colcache_close(struct ColumnCache *cache) {
+  if (cache == NULL)
+    return;
+
+  sidecar_unmap(cache->data, cache->size);
+  free(cache->columns);
+  free(cache);
+}
+
+//
+// colcache_decode
+//
+void colcache_decode(struct ColumnCache *cache, int rowNum,
+                     const bool *needed, struct FieldValue *values) {
+  for (int i = 0; i < cache->numColumns; i++) {
+    if (needed != NULL && !needed[i])
+      continue;
+
+    struct CacheColumn *col = &cache->columns[i];
+
+    if (col->colType == COL_TYPE_INT) {
+      values[i].value.i = col->ints[rowNum];
+    } else if (col->colType == COL_TYPE_REAL) {
+      values[i].value.r = col->reals[rowNum];
+    } else {
+      values[i].value.str.s = col->blob + col->offsets[rowNum];
+      values[i].value.str.len =
+          (int)(col->offsets[rowNum + 1] - col->offsets[rowNum] - 1);
+    }
+    values[i].valueType = col->colType;
+  }
+}
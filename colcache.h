@@ -0,0 +1,100 @@
+/*colcache.h*/
+
+//
+// Project: Columnar cache of table data for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+#include <stdint.h>  // int32_t, uint64_t
+
+#include "database.h"
+#include "decoder.h"
+#include "sidecar.h"
+#include "tablefile.h"
+
+//
+// A ColumnCache is a binary, column-oriented copy of a table's
+// .data file, stored next to it as "TABLE-NAME.col". Each column
+// is one contiguous segment: an int32_t array, a double array, or
+// for strings an array of numRows+1 offsets into a blob of
+// null-terminated strings. The cache is only used while the .data
+// file has the same size and modification time as when the cache
+// was written, otherwise it is rebuilt.
+//
+// The file is mapped into memory, so the column arrays below point
+// directly into the mapping.
+//
+struct ColumnCache
+{
+  char        path[SIDECAR_MAX_PATH]; // name/name.col
+  const char* data;  // the mapped file
+  size_t      size;  // # of bytes in the file
+
+  int numRows;
+  int numColumns;
+  struct CacheColumn* columns;  // pointer to ARRAY of columns
+};
+
+struct CacheColumn
+{
+  int colType;  // enum ColumnType (database.h)
+
+  const int32_t*  ints;     // COL_TYPE_INT: numRows values
+  const double*   reals;    // COL_TYPE_REAL: numRows values
+  const uint64_t* offsets;  // COL_TYPE_STRING: numRows+1 offsets into blob
+  const char*     blob;     // COL_TYPE_STRING: the strings, back to back
+};
+
+
+//
+// Functions:
+//
+
+//
+// colcache_open
+//
+// Opens and maps the cache for the given table. Returns NULL if
+// there is no cache, or if it does not match the table's current
+// .data file or meta-data.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling colcache_close().
+//
+struct ColumnCache* colcache_open(struct Database* db, struct TableMeta* tablemeta);
+
+//
+// colcache_build
+//
+// Decodes every record of the given table file and writes the
+// cache for the table, replacing any existing cache, and then
+// opens it. Returns NULL if the cache could not be written (e.g.
+// the directory is read-only), in which case the caller should
+// keep using the .data file.
+//
+struct ColumnCache* colcache_build(struct Database* db,
+  struct TableMeta* tablemeta, struct TableFile* tablefile);
+
+//
+// colcache_close
+//
+// Unmaps the cache and frees the memory associated with it.
+//
+void colcache_close(struct ColumnCache* cache);
+
+//
+// colcache_decode
+//
+// Fills values with the fields of row rowNum, where 0 <= rowNum <
+// cache->numRows. Only the columns i where needed[i] is true are
+// filled in; pass NULL for needed to fill in every column. String
+// values point into the cache (and happen to be null-terminated).
+//
+void colcache_decode(struct ColumnCache* cache, int rowNum /*0..N-1*/,
+  const bool* needed, struct FieldValue* values);
@@ -0,0 +1,510 @@
+/*colvec.c*/
+
+//
+// Project: Typed column vectors for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memcpy, memcmp, strcmp, strlen
+
+#include "colvec.h"
+#include "rsutil.h"
+#include "util.h"
+
+#define COLVEC_INITIAL_ROWS 64
+
+// grows the typed arrays of every column so they have room for at
+// least numRows rows
+static void reserveRows(struct ColumnVectors *vectors, int numRows) {
+  if (numRows <= vectors->capacity)
+    return;
+
+  int capacity = vectors->capacity * 2;
+  if (capacity < COLVEC_INITIAL_ROWS)
+    capacity = COLVEC_INITIAL_ROWS;
+  if (capacity < numRows)
+    capacity = numRows;
+
+  for (int c = 0; c < vectors->numColumns; c++) {
+    struct VectorColumn *col = &vectors->columns[c];
+
+    if (col->colType == COL_TYPE_INT) {
+      col->ints = (int32_t *)realloc(col->ints, sizeof(int32_t) * capacity);
+      if (col->ints == NULL)
+        panic("out of memory");
+    } else if (col->colType == COL_TYPE_REAL) {
+      col->reals = (double *)realloc(col->reals, sizeof(double) * capacity);
+      if (col->reals == NULL)
+        panic("out of memory");
+    } else {
+      col->offsets =
+          (size_t *)realloc(col->offsets, sizeof(size_t) * (capacity + 1));
+      if (col->offsets == NULL)
+        panic("out of memory");
+    }
+  }
+
+  vectors->capacity = capacity;
+}
+
+// grows the blob of the string column so it has room for size bytes
+static void reserveBlob(struct VectorColumn *col, size_t size) {
+  if (size <= col->blobCapacity)
+    return;
+
+  size_t capacity = col->blobCapacity * 2;
+  if (capacity < size)
+    capacity = size;
+
+  col->blob = (char *)realloc(col->blob, capacity);
+  if (col->blob == NULL)
+    panic("out of memory");
+  col->blobCapacity = capacity;
+}
+
+// returns a view of the string in the given row of the string column
+static struct StringView stringAt(const struct VectorColumn *col, int row) {
+  struct StringView view;
+  view.s = col->blob + col->offsets[row];
+  view.len = (int)(col->offsets[row + 1] - col->offsets[row] - 1);
+  return view;
+}
+
+//
+// colvec_create
+//
+struct ColumnVectors *colvec_create(struct TableMeta *tablemeta,
+                                    const bool *needed) {
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (colvec_create)");
+
+  struct ColumnVectors *vectors =
+      (struct ColumnVectors *)malloc(sizeof(struct ColumnVectors));
+  struct VectorColumn *columns = (struct VectorColumn *)malloc(
+      sizeof(struct VectorColumn) * tablemeta->numColumns);
+  if (vectors == NULL || columns == NULL)
+    panic("out of memory");
+
+  vectors->tablemeta = tablemeta;
+  vectors->numRows = 0;
+  vectors->numColumns = 0;
+  vectors->columns = columns;
+  vectors->capacity = 0;
+
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    if (!needed[i])
+      continue;
+
+    struct VectorColumn *col = &columns[vectors->numColumns];
+    col->column = i;
+    col->colType = tablemeta->columns[i].colType;
+    col->ints = NULL;
+    col->reals = NULL;
+    col->offsets = NULL;
+    col->blob = NULL;
+    col->blobCapacity = 0;
+    vectors->numColumns++;
+  }
+
+  // strings have an offset for the end of the last one, even with no rows
+  reserveRows(vectors, COLVEC_INITIAL_ROWS);
+  for (int c = 0; c < vectors->numColumns; c++) {
+    if (columns[c].colType == COL_TYPE_STRING)
+      columns[c].offsets[0] = 0;
+  }
+
+  return vectors;
+}
+
+//
+// colvec_destroy
+//
+void colvec_destroy(struct ColumnVectors *vectors) {
+  if (vectors == NULL)
+    return;
+
+  for (int c = 0; c < vectors->numColumns; c++) {
+    free(vectors->columns[c].ints);
+    free(vectors->columns[c].reals);
+    free(vectors->columns[c].offsets);
+    free(vectors->columns[c].blob);
+  }
+
+  free(vectors->columns);
+  free(vectors);
+}
+
+//
+// colvec_addRow
+//
+void colvec_addRow(struct ColumnVectors *vectors,
+                   const struct FieldValue *values) {
+  int row = vectors->numRows;
+  reserveRows(vectors, row + 1);
+
+  for (int c = 0; c < vectors->numColumns; c++) {
+    struct VectorColumn *col = &vectors->columns[c];
+    const struct FieldValue *value = &values[col->column];
+
+    if (col->colType == COL_TYPE_INT) {
+      col->ints[row] = value->value.i;
+    } else if (col->colType == COL_TYPE_REAL) {
+      col->reals[row] = value->value.r;
+    } else { // copied in, and null-terminated
+      size_t start = col->offsets[row];
+      size_t len = (size_t)value->value.str.len;
+      reserveBlob(col, start + len + 1);
+      memcpy(col->blob + start, value->value.str.s, len);
+      col->blob[start + len] = '\0';
+      col->offsets[row + 1] = start + len + 1;
+    }
+  }
+
+  vectors->numRows++;
+}
+
+//
+// colvec_appendRows
+//
+void colvec_appendRows(struct ColumnVectors *dst, struct ColumnVectors *src) {
+  if (dst == NULL || src == NULL)
+    panic("vectors are NULL (colvec_appendRows)");
+  if (dst->numColumns != src->numColumns)
+    panic("vectors have different columns (colvec_appendRows)");
+
+  int first = dst->numRows;
+  int count = src->numRows;
+  reserveRows(dst, first + count);
+
+  for (int c = 0; c < dst->numColumns; c++) {
+    struct VectorColumn *dstCol = &dst->columns[c];
+    struct VectorColumn *srcCol = &src->columns[c];
+    if (dstCol->colType != srcCol->colType)
+      panic("vectors have different columns (colvec_appendRows)");
+
+    if (dstCol->colType == COL_TYPE_INT) {
+      memcpy(&dstCol->ints[first], srcCol->ints, sizeof(int32_t) * count);
+    } else if (dstCol->colType == COL_TYPE_REAL) {
+      memcpy(&dstCol->reals[first], srcCol->reals, sizeof(double) * count);
+    } else { // the blob is copied as is, and its offsets shifted past dst's
+      size_t base = dstCol->offsets[first];
+      size_t blobSize = srcCol->offsets[count];
+      reserveBlob(dstCol, base + blobSize);
+      if (blobSize > 0)
+        memcpy(dstCol->blob + base, srcCol->blob, blobSize);
+      for (int r = 1; r <= count; r++) {
+        dstCol->offsets[first + r] = base + srcCol->offsets[r];
+      }
+      srcCol->offsets[0] = 0;
+    }
+  }
+
+  dst->numRows += count;
+  src->numRows = 0;
+}
+
+//
+// colvec_ints
+//
+const int32_t *colvec_ints(struct ColumnVectors *vectors, int colNum) {
+  if (colNum < 0 || colNum >= vectors->numColumns ||
+      vectors->columns[colNum].colType != COL_TYPE_INT)
+    panic("not an int column (colvec_ints)");
+
+  return vectors->columns[colNum].ints;
+}
+
+//
+// colvec_reals
+//
+const double *colvec_reals(struct ColumnVectors *vectors, int colNum) {
+  if (colNum < 0 || colNum >= vectors->numColumns ||
+      vectors->columns[colNum].colType != COL_TYPE_REAL)
+    panic("not a real column (colvec_reals)");
+
+  return vectors->columns[colNum].reals;
+}
+
+//
+// colvec_getStringView
+//
+struct StringView colvec_getStringView(struct ColumnVectors *vectors,
+                                       int colNum, int row) {
+  if (colNum < 0 || colNum >= vectors->numColumns ||
+      vectors->columns[colNum].colType != COL_TYPE_STRING)
+    panic("not a string column (colvec_getStringView)");
+  if (row < 0 || row >= vectors->numRows)
+    panic("invalid row (colvec_getStringView)");
+
+  return stringAt(&vectors->columns[colNum], row);
+}
+
+// compares two strings just like strcmp would, without looking for
+// their ends
+static int compareViews(struct StringView a, struct StringView b) {
+  int cmp = memcmp(a.s, b.s, (a.len < b.len) ? a.len : b.len);
+  if (cmp != 0)
+    return cmp;
+  return (a.len > b.len) - (a.len < b.len);
+}
+
+//
+// colvec_computeFunction
+//
+void colvec_computeFunction(struct ColumnVectors *vectors, int colNum,
+                            int numRows, int function, struct RSValue *value) {
+  if (colNum < 0 || colNum >= vectors->numColumns)
+    panic("invalid column (colvec_computeFunction)");
+  if (numRows < 1 || numRows > vectors->numRows)
+    panic("invalid # of rows (colvec_computeFunction)");
+
+  int colType = vectors->columns[colNum].colType;
+  value->valueType = colType;
+
+  if (function == COUNT_FUNCTION) {
+    value->value.i = numRows;
+    value->valueType = COL_TYPE_INT;
+  } else if (colType == COL_TYPE_INT) {
+    //
+    // ints are summed in int arithmetic, wrapping around the way
+    // resultset_applyFunction's sum does, and AVG is that sum over
+    // the # of rows:
+    //
+    const int32_t *ints = colvec_ints(vectors, colNum);
+    int result = ints[0];
+    unsigned int sum = 0;
+    for (int r = 0; r < numRows; r++) {
+      if ((function == MIN_FUNCTION && ints[r] < result) ||
+          (function == MAX_FUNCTION && ints[r] > result))
+        result = ints[r];
+      sum += (unsigned int)ints[r];
+    }
+
+    if (function == SUM_FUNCTION) {
+      result = (int)sum;
+    } else if (function == AVG_FUNCTION) {
+      value->value.r = (double)(int)sum / numRows;
+      value->valueType = COL_TYPE_REAL;
+      return;
+    }
+    value->value.i = result;
+  } else if (colType == COL_TYPE_REAL) {
+    const double *reals = colvec_reals(vectors, colNum);
+    double result = reals[0];
+    double sum = 0.0;
+    for (int r = 0; r < numRows; r++) {
+      if ((function == MIN_FUNCTION && reals[r] < result) ||
+          (function == MAX_FUNCTION && reals[r] > result))
+        result = reals[r];
+      sum += reals[r];
+    }
+
+    if (function == SUM_FUNCTION)
+      result = sum;
+    else if (function == AVG_FUNCTION)
+      result = sum / numRows;
+    value->value.r = result;
+  } else {
+    if (function != MIN_FUNCTION && function != MAX_FUNCTION)
+      panic("cannot apply SUM or AVG to a string column "
+            "(colvec_computeFunction)");
+
+    struct StringView result = colvec_getStringView(vectors, colNum, 0);
+    for (int r = 1; r < numRows; r++) {
+      struct StringView view = colvec_getStringView(vectors, colNum, r);
+      if ((function == MIN_FUNCTION && compareViews(view, result) < 0) ||
+          (function == MAX_FUNCTION && compareViews(view, result) > 0))
+        result = view;
+    }
+    value->value.s = (char *)result.s;
+  }
+}
+
+//
+// colvec_toResultSet
+//
+struct ResultSet *colvec_toResultSet(struct ColumnVectors *vectors,
+                                     int maxRows) {
+  if (vectors == NULL)
+    panic("vectors are NULL (colvec_toResultSet)");
+
+  int numRows = vectors->numRows;
+  if (maxRows >= 0 && maxRows < numRows)
+    numRows = maxRows;
+
+  struct TableMeta *tablemeta = vectors->tablemeta;
+  struct ResultSet *rs = resultset_create();
+
+  //
+  // each column's array of values is sized for all the rows up front,
+  // and then filled in from the typed array in a single loop; the
+  // strings are borrowed from the arena, so none are allocated:
+  //
+  struct RSColumn *rsCol = NULL;
+  for (int c = 0; c < vectors->numColumns; c++) {
+    struct VectorColumn *col = &vectors->columns[c];
+    resultset_insertColumn(rs, rs->numCols + 1, tablemeta->name,
+                           tablemeta->columns[col->column].name, NO_FUNCTION,
+                           col->colType);
+    rsCol = (rsCol == NULL) ? rs->columns : rsCol->next;
+
+    if (numRows > rsCol->size) {
+      rsCol->data = (struct RSValue *)realloc(rsCol->data,
+                                              sizeof(struct RSValue) * numRows);
+      if (rsCol->data == NULL)
+        panic("out of memory");
+      rsCol->size = numRows;
+    }
+
+    struct RSValue *data = rsCol->data;
+    if (col->colType == COL_TYPE_INT) {
+      for (int r = 0; r < numRows; r++) {
+        data[r].value.i = col->ints[r];
+        data[r].valueType = COL_TYPE_INT;
+      }
+    } else if (col->colType == COL_TYPE_REAL) {
+      for (int r = 0; r < numRows; r++) {
+        data[r].value.r = col->reals[r];
+        data[r].valueType = COL_TYPE_REAL;
+      }
+    } else {
+      for (int r = 0; r < numRows; r++) {
+        data[r].value.s = (char *)stringAt(col, r).s;
+        data[r].valueType = COL_TYPE_STRING;
+      }
+    }
+    rsCol->N = numRows;
+  }
+
+  rs->numRows = numRows;
+  return rs;
+}
+
+// returns the # of the vectors' column (0-based) that the given
+// result set column was made from, or -1 if there is none; the column
+// is matched by name, once, rather than each of its values being
+// checked against every arena
+static int findColumn(struct ColumnVectors *vectors, struct RSColumn *column) {
+  if (vectors == NULL || column == NULL)
+    return -1;
+
+  for (int c = 0; c < vectors->numColumns; c++) {
+    int i = vectors->columns[c].column;
+    if (strcmp(vectors->tablemeta->columns[i].name, column->colName) == 0)
+      return c;
+  }
+  return -1;
+}
+
+// releases the strings that the given result set column borrows from
+// the vectors' arenas, in rows firstRow and up (0-based), by setting
+// them to NULL, so the result set can then free the column's values
+// as usual (freeing NULL does nothing)
+static void releaseStrings(struct ColumnVectors *vectors,
+                           struct RSColumn *column, int firstRow) {
+  int c = findColumn(vectors, column);
+  if (c < 0 || vectors->columns[c].colType != COL_TYPE_STRING)
+    return;
+
+  struct VectorColumn *col = &vectors->columns[c];
+  const char *start = col->blob;
+  const char *end = col->blob + col->offsets[vectors->numRows];
+
+  for (int r = (firstRow < 0) ? 0 : firstRow; r < column->N; r++) {
+    struct RSValue *value = &column->data[r];
+    if (value->valueType == COL_TYPE_STRING && value->value.s >= start &&
+        value->value.s < end)
+      value->value.s = NULL;
+  }
+}
+
+// returns the column at the given position (1-based), or NULL if
+// there is none
+static struct RSColumn *columnAt(struct ResultSet *rs, int position) {
+  struct RSColumn *column = rs->columns;
+  for (int i = 1; i < position && column != NULL; i++) {
+    column = column->next;
+  }
+  return (position < 1) ? NULL : column;
+}
+
+//
+// colvec_deleteColumn
+//
+void colvec_deleteColumn(struct ColumnVectors *vectors, struct ResultSet *rs,
+                         int position) {
+  releaseStrings(vectors, columnAt(rs, position), 0);
+  resultset_deleteColumn(rs, position);
+}
+
+//
+// colvec_applyFunction
+//
+void colvec_applyFunction(struct ColumnVectors *vectors, struct ResultSet *rs,
+                          int function, int position) {
+  struct RSColumn *column = columnAt(rs, position);
+  int c = findColumn(vectors, column);
+  if (c < 0) { // borrows nothing, or isn't there at all
+    resultset_applyFunction(rs, function, position);
+    return;
+  }
+
+  // like resultset_applyFunction, no rows means no value at all
+  if (column->N == 0)
+    return;
+
+  //
+  // the function is computed on the vectors' typed array, and its
+  // value replaces the column's values, just as resultset_applyFunction
+  // would replace them; the other values are all borrowed, so there is
+  // nothing to free, and only a string value needs a copy of its own:
+  //
+  struct RSValue value;
+  colvec_computeFunction(vectors, c, column->N, function, &value);
+
+  if (value.valueType == COL_TYPE_STRING) {
+    size_t size = strlen(value.value.s) + 1;
+    char *s = (char *)malloc(size);
+    if (s == NULL)
+      panic("out of memory");
+    memcpy(s, value.value.s, size);
+    value.value.s = s;
+  }
+
+  column->data[0] = value;
+  column->N = 1;
+  column->cursor = 0;
+  column->function = function;
+  column->coltype = value.valueType;
+  rs->numRows = 1;
+}
+
+//
+// colvec_truncateRows
+//
+void colvec_truncateRows(struct ColumnVectors *vectors, struct ResultSet *rs,
+                         int numRows) {
+  for (struct RSColumn *col = rs->columns; col != NULL; col = col->next) {
+    releaseStrings(vectors, col, numRows);
+  }
+  rsutil_truncateRows(rs, numRows);
+}
+
+//
+// colvec_destroyResultSet
+//
+void colvec_destroyResultSet(struct ColumnVectors *vectors,
+                             struct ResultSet *rs) {
+  if (rs == NULL)
+    return;
+
+  for (struct RSColumn *col = rs->columns; col != NULL; col = col->next) {
+    releaseStrings(vectors, col, 0);
+  }
+  resultset_destroy(rs);
+}
@@ -0,0 +1,194 @@
+/*colvec.h*/
+
+//
+// Project: Typed column vectors for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+#include <stdint.h>  // int32_t
+
+#include "database.h"
+#include "decoder.h"
+#include "resultset.h"
+
+//
+// ColumnVectors hold the rows of a scan in memory the way the
+// columnar cache holds them on disk: one contiguous, typed array per
+// column --- int32_t values, double values, or for strings an array
+// of numRows+1 offsets into a blob of null-terminated strings. Unlike
+// a ResultSet, whose columns are arrays of 16-byte tagged values and
+// whose strings are allocated one by one, an int column takes 4 bytes
+// per row and a string column a single growing buffer, and a loop
+// over a column is a loop over a plain array.
+//
+// A scan fills in ColumnVectors, and only the rows it returns are
+// turned into a ResultSet at the very end, once. The blob of a string
+// column is an arena: its strings are appended one after the other,
+// and all of them are freed at once with the vectors. A ResultSet
+// made from the vectors borrows its strings from there, rather than
+// allocating (and later freeing) each of them separately.
+//
+struct ColumnVectors
+{
+  struct TableMeta*    tablemeta;
+  int                  numRows;
+  int                  numColumns;
+  struct VectorColumn* columns;   // pointer to ARRAY of columns
+  int                  capacity;  // # of rows each array has room for
+};
+
+struct VectorColumn
+{
+  int column;   // index of the column in the table (0-based)
+  int colType;  // enum ColumnType (database.h)
+
+  int32_t* ints;     // COL_TYPE_INT: numRows values
+  double*  reals;    // COL_TYPE_REAL: numRows values
+  size_t*  offsets;  // COL_TYPE_STRING: numRows+1 offsets into blob
+  char*    blob;     // COL_TYPE_STRING: the strings, back to back
+  size_t   blobCapacity;
+};
+
+//
+// A StringView is one string of a string column, borrowed rather than
+// copied: it points into the column's blob, where it is null-terminated,
+// and carries its length, so reading it takes neither a copy nor a
+// strlen. Like the blob, it is valid until rows are added to the
+// vectors or they are destroyed.
+//
+struct StringView
+{
+  const char* s;
+  int         len;
+};
+
+
+//
+// Functions:
+//
+
+//
+// colvec_create
+//
+// Creates empty column vectors with one column for each needed
+// column of the table, in table order.
+//
+// NOTE: it is the caller's responsibility to free the vectors
+// by calling colvec_destroy().
+//
+struct ColumnVectors* colvec_create(struct TableMeta* tablemeta,
+  const bool* needed);
+
+//
+// colvec_destroy
+//
+// Frees all the memory associated with the column vectors.
+//
+void colvec_destroy(struct ColumnVectors* vectors);
+
+//
+// colvec_addRow
+//
+// Adds a row to the end of the vectors, taking the value of each of
+// their columns from values[i], where i is the column's index in
+// the table (as filled in by colcache_decode() or decoder_decode()).
+// Strings are copied.
+//
+void colvec_addRow(struct ColumnVectors* vectors,
+  const struct FieldValue* values);
+
+//
+// colvec_appendRows
+//
+// Moves all the rows of src to the end of dst, in order. The two
+// must have the same columns. After the call src has no rows.
+//
+void colvec_appendRows(struct ColumnVectors* dst, struct ColumnVectors* src);
+
+//
+// colvec_ints, colvec_reals
+//
+// Return the numRows values of the given column (0-based, in the
+// order of the vectors' columns), which must be of that type.
+//
+const int32_t* colvec_ints(struct ColumnVectors* vectors, int colNum);
+const double*  colvec_reals(struct ColumnVectors* vectors, int colNum);
+
+//
+// colvec_getStringView
+//
+// Returns a view of the string in the given row (0-based) of the
+// given string column. Nothing is copied or allocated, and there is
+// nothing to free.
+//
+struct StringView colvec_getStringView(struct ColumnVectors* vectors,
+  int colNum, int row);
+
+//
+// colvec_computeFunction
+//
+// Computes the given function --- one of enum AST_COLUMN_FUNCTIONS,
+// but not NO_FUNCTION --- over the first numRows rows (at least 1) of
+// the given column, looping over its typed array, and stores the
+// result in value. The result is the one resultset_applyFunction()
+// would compute: ints are summed in int arithmetic, AVG is a real,
+// COUNT an int, and strings compare as with strcmp, via their views
+// (SUM and AVG of a string column are an error). A string result is
+// not copied: it points into the vectors' arena.
+//
+void colvec_computeFunction(struct ColumnVectors* vectors, int colNum,
+  int numRows, int function, struct RSValue* value);
+
+//
+// colvec_toResultSet
+//
+// Creates a result set with a column for each of the vectors'
+// columns, and copies the first maxRows rows into it, or all of
+// them if maxRows is -1 or there are fewer. Strings are not copied:
+// they point into the vectors' arenas, so the vectors must not be
+// destroyed or added to before the result set is.
+//
+// NOTE: the resultset_* functions free the strings of the values they
+// delete, so a column of the result set must be deleted, have a
+// function applied, or lose rows only via the colvec_* functions
+// below, and the result set can only be destroyed by calling
+// colvec_destroyResultSet() --- never resultset_destroy() --- and
+// before the vectors are.
+//
+struct ResultSet* colvec_toResultSet(struct ColumnVectors* vectors,
+  int maxRows);
+
+//
+// colvec_deleteColumn, colvec_applyFunction, colvec_truncateRows
+//
+// Same as resultset_deleteColumn(), resultset_applyFunction() and
+// rsutil_truncateRows() on a result set made by colvec_toResultSet(),
+// but the strings being deleted are first released from the vectors'
+// arenas. A function is computed by colvec_computeFunction(), so the
+// column's strings are never copied, only the function's value. If
+// vectors is NULL, the result set borrows nothing and these are the
+// same as the others.
+//
+void colvec_deleteColumn(struct ColumnVectors* vectors, struct ResultSet* rs,
+  int position);
+void colvec_applyFunction(struct ColumnVectors* vectors, struct ResultSet* rs,
+  int function, int position);
+void colvec_truncateRows(struct ColumnVectors* vectors, struct ResultSet* rs,
+  int numRows);
+
+//
+// colvec_destroyResultSet
+//
+// Frees all the memory associated with a result set made by
+// colvec_toResultSet(), except the strings it borrows from the
+// vectors, which are freed with them by colvec_destroy().
+//
+void colvec_destroyResultSet(struct ColumnVectors* vectors,
+  struct ResultSet* rs);
@@ -0,0 +1,198 @@
+/*decoder.c*/
+
+//
+// Project: Schema-driven record decoder for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <stdbool.h> // true, false
+#include <stdio.h>
+#include <stdlib.h> // strtod
+#include <string.h> // memchr
+
+#include "database.h"
+#include "decoder.h"
+#include "util.h"
+
+// exact powers of 10 as doubles, used to scale real fields
+static const double powersOf10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                    1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                    1e18, 1e19, 1e20, 1e21, 1e22};
+
+// decodes an int field, e.g. 1999 or -5
+static const char *decodeInt(const char *cp, const char *recordEnd,
+                             struct FieldValue *out) {
+  bool negative = false;
+  if (*cp == '-') {
+    negative = true;
+    cp++;
+  }
+
+  int value = 0;
+  while (cp < recordEnd && *cp >= '0' && *cp <= '9') {
+    value = (value * 10) + (*cp - '0');
+    cp++;
+  }
+
+  out->value.i = negative ? -value : value;
+  out->valueType = COL_TYPE_INT;
+  return cp + 1; // skips the blank after the field
+}
+
+// decodes a real field, e.g. 463517383.00
+static const char *decodeReal(const char *cp, const char *recordEnd,
+                              struct FieldValue *out) {
+  const char *start = cp;
+
+  bool negative = false;
+  if (*cp == '-') {
+    negative = true;
+    cp++;
+  }
+
+  // collects the digits on both sides of the decimal point as one
+  // integer, and counts how many of them follow the point
+  unsigned long long digits = 0;
+  int numDigits = 0;
+  int numDecimals = 0;
+  while (cp < recordEnd && *cp >= '0' && *cp <= '9') {
+    digits = (digits * 10) + (*cp - '0');
+    numDigits++;
+    cp++;
+  }
+  if (cp < recordEnd && *cp == '.') {
+    cp++;
+    while (cp < recordEnd && *cp >= '0' && *cp <= '9') {
+      digits = (digits * 10) + (*cp - '0');
+      numDigits++;
+      numDecimals++;
+      cp++;
+    }
+  }
+
+  if (numDigits <= 15 && (*cp == ' ' || *cp == '$')) {
+    // both the digits and the power of 10 are exact as doubles, so a
+    // single division gives the correctly rounded value
+    double value = (double)digits / powersOf10[numDecimals];
+    out->value.r = negative ? -value : value;
+  } else { // too many digits or an exponent, let the C library do it
+    char *after = NULL;
+    out->value.r = strtod(start, &after);
+    cp = after;
+  }
+
+  out->valueType = COL_TYPE_REAL;
+  return cp + 1; // skips the blank after the field
+}
+
+// decodes a string field, which is enclosed in either single or double
+// quotes; the other kind of quote may appear inside the string
+static const char *decodeString(const char *cp, const char *recordEnd,
+                                struct FieldValue *out) {
+  char quote = *cp;
+  if (quote != '\"' && quote != '\'')
+    panic("string field is not quoted in data file (decoder_decode)");
+
+  const char *close = memchr(cp + 1, quote, recordEnd - cp - 1);
+  if (close == NULL)
+    panic("unterminated string in data file (decoder_decode)");
+
+  out->value.str.s = cp + 1;
+  out->value.str.len = (int)(close - cp - 1);
+  out->valueType = COL_TYPE_STRING;
+  return close + 2; // skips the closing quote and the blank after it
+}
+
+// skips over an int or real field without decoding it
+static const char *skipNumber(const char *cp, const char *recordEnd,
+                              struct FieldValue *out) {
+  (void)out; // a FieldDecoder, but nothing is decoded
+  const char *blank = memchr(cp, ' ', recordEnd - cp);
+  return (blank == NULL) ? recordEnd : blank + 1;
+}
+
+// skips over a string field without decoding it
+static const char *skipString(const char *cp, const char *recordEnd,
+                              struct FieldValue *out) {
+  (void)out; // a FieldDecoder, but nothing is decoded
+  const char *close = memchr(cp + 1, *cp, recordEnd - cp - 1);
+  if (close == NULL)
+    panic("unterminated string in data file (decoder_decode)");
+
+  return close + 2; // skips the closing quote and the blank after it
+}
+
+//
+// decoder_create
+//
+struct RecordDecoder *decoder_create(struct TableMeta *tablemeta,
+                                     const bool *needed) {
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (decoder_create)");
+
+  struct RecordDecoder *decoder =
+      (struct RecordDecoder *)malloc(sizeof(struct RecordDecoder));
+  if (decoder == NULL)
+    panic("out of memory");
+
+  decoder->numColumns = tablemeta->numColumns;
+  decoder->numDecoders = 0;
+  decoder->recordSize = tablemeta->recordSize;
+  decoder->decoders =
+      (FieldDecoder *)malloc(sizeof(FieldDecoder) * tablemeta->numColumns);
+  if (decoder->decoders == NULL)
+    panic("out of memory");
+
+  // picks the routine for each column once, based on its type and
+  // whether the column is needed at all
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    int colType = tablemeta->columns[i].colType;
+    if (needed != NULL && !needed[i]) {
+      decoder->decoders[i] =
+          (colType == COL_TYPE_STRING) ? skipString : skipNumber;
+      continue;
+    }
+
+    decoder->numDecoders = i + 1; // fields after the last needed one are
+                                  // never visited
+    if (colType == COL_TYPE_INT) {
+      decoder->decoders[i] = decodeInt;
+    } else if (colType == COL_TYPE_REAL) {
+      decoder->decoders[i] = decodeReal;
+    } else if (colType == COL_TYPE_STRING) {
+      decoder->decoders[i] = decodeString;
+    } else {
+      panic("unknown column type (decoder_create)");
+    }
+  }
+
+  return decoder;
+}
+
+//
+// decoder_destroy
+//
+void decoder_destroy(struct RecordDecoder *decoder) {
+  if (decoder == NULL)
+    return;
+
+  free(decoder->decoders);
+  free(decoder);
+}
+
+//
+// decoder_decode
+//
+void decoder_decode(struct RecordDecoder *decoder, const char *record,
+                    struct FieldValue *values) {
+  const char *recordEnd = record + decoder->recordSize; // the $ marker
+  const char *cp = record;
+
+  for (int i = 0; i < decoder->numDecoders; i++) {
+    cp = decoder->decoders[i](cp, recordEnd, &values[i]);
+  }
+}
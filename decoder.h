@@ -0,0 +1,95 @@
+/*decoder.h*/
+
+//
+// Project: Schema-driven record decoder for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+
+#include "database.h"
+
+//
+// A FieldValue is one decoded field of a record. Strings are not
+// copied: they point into the record (just past the opening quote)
+// and carry their length, since they are not null-terminated.
+//
+struct FieldValue
+{
+  union
+  {
+    int    i;
+    double r;
+    struct
+    {
+      const char* s;
+      int         len;
+    } str;
+  } value;
+
+  int valueType;  // enum ColumnType (database.h)
+};
+
+//
+// A field decoder parses the field starting at cp, stores it in
+// *out, and returns a pointer to the start of the next field. The
+// field must end before recordEnd.
+//
+typedef const char* (*FieldDecoder)(const char* cp, const char* recordEnd,
+  struct FieldValue* out);
+
+//
+// A RecordDecoder is built once per table from the column types
+// in the table's meta-data, with one specialized routine per column,
+// so records are decoded in a single pass with no type inference.
+// Columns the query doesn't need get a routine that only skips
+// over the field, and decoding stops after the last needed column.
+//
+struct RecordDecoder
+{
+  int           numColumns;  // # of columns in the table
+  int           numDecoders; // # of leading columns that are visited
+  int           recordSize;
+  FieldDecoder* decoders;    // pointer to ARRAY of per-column decoders
+};
+
+
+//
+// Functions:
+//
+
+//
+// decoder_create
+//
+// Builds a decoder for the records of the given table. Only the
+// columns i where needed[i] is true are decoded; pass NULL for
+// needed to decode every column.
+//
+// NOTE: it is the caller's responsibility to free the decoder
+// by calling decoder_destroy().
+//
+struct RecordDecoder* decoder_create(struct TableMeta* tablemeta,
+  const bool* needed);
+
+//
+// decoder_destroy
+//
+// Frees the memory associated with the decoder.
+//
+void decoder_destroy(struct RecordDecoder* decoder);
+
+//
+// decoder_decode
+//
+// Decodes the needed fields of the given record into values, which
+// must have room for decoder->numColumns entries; the entries of
+// the other columns are left as is. The record is one fixed-width
+// record of the table's .data file.
+//
+void decoder_decode(struct RecordDecoder* decoder, const char* record,
+  struct FieldValue* values);
@@ -0,0 +1,275 @@
+/*directmap.c*/
+
+//
+// Project: Direct-address key maps for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int32_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memset, strcpy, strcat
+
+#include "colcache.h"
+#include "database.h"
+#include "decoder.h"
+#include "directmap.h"
+#include "sidecar.h"
+#include "tablefile.h"
+#include "util.h"
+
+#define DIRECTMAP_MAGIC "SSQLDMP1"
+
+//
+// On-disk layout: a DirectMapHeader, followed, if the keys are dense,
+// by the numSlots+1 starting positions, and then the numRecords
+// record #s.
+//
+struct DirectMapHeader
+{
+  struct SidecarStamp stamp;  // the .data file the map was built from
+  int32_t             column;
+  int32_t             dense;  // 0 => no arrays follow
+  int32_t             minKey;
+  int32_t             numSlots;
+};
+
+// returns true if a range of numSlots keys is dense enough to map for
+// numRecords records
+static bool isDense(long long numSlots, long long numRecords) {
+  return numRecords > 0 &&
+         numSlots <= DIRECTMAP_MAX_SLOTS_PER_RECORD * numRecords;
+}
+
+// builds ".COLUMN-NAME.dmap", the extension of the map's sidecar
+static void buildExtension(char *ext, struct TableMeta *tablemeta, int column) {
+  strcpy(ext, ".");
+  strcat(ext, tablemeta->columns[column].name);
+  strcat(ext, ".dmap");
+}
+
+//
+// directmap_open
+//
+struct DirectMap *directmap_open(struct Database *db,
+                                 struct TableMeta *tablemeta, int column) {
+  if (db == NULL)
+    panic("db is NULL (directmap_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (directmap_open)");
+
+  struct SidecarStamp stamp;
+  if (!sidecar_stamp(&stamp, db, tablemeta, DIRECTMAP_MAGIC))
+    return NULL;
+
+  struct DirectMap *dmap = (struct DirectMap *)malloc(sizeof(struct DirectMap));
+  if (dmap == NULL)
+    panic("out of memory");
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(dmap->path, db, tablemeta, ext);
+
+  // the map must have been built from the current .data file:
+  dmap->data = sidecar_map(dmap->path, &stamp, &dmap->size);
+  if (dmap->data == NULL) { // no map yet, or stale
+    free(dmap);
+    return NULL;
+  }
+
+  //
+  // ... and with the current meta-data:
+  //
+  const struct DirectMapHeader *header =
+      (const struct DirectMapHeader *)dmap->data;
+  size_t numRecords = (size_t)header->stamp.numRecords;
+
+  bool valid = sizeof(struct DirectMapHeader) <= dmap->size &&
+               header->column == column &&
+               tablemeta->columns[column].colType == COL_TYPE_INT &&
+               header->numSlots >= 0 &&
+               (header->dense == 0 ||
+                (isDense(header->numSlots, (long long)numRecords) &&
+                 sizeof(struct DirectMapHeader) +
+                         ((size_t)header->numSlots + 1 + numRecords) *
+                             sizeof(int32_t) <=
+                     dmap->size));
+
+  // (a map built under a looser density limit is rebuilt, too)
+  if (!valid) { // damaged, the caller will rebuild it
+    sidecar_unmap(dmap->data, dmap->size);
+    free(dmap);
+    return NULL;
+  }
+
+  dmap->column = column;
+  dmap->dense = (header->dense != 0);
+  dmap->minKey = header->minKey;
+  dmap->numSlots = header->numSlots;
+  dmap->starts =
+      (const int32_t *)(dmap->data + sizeof(struct DirectMapHeader));
+  dmap->recNums = dmap->starts + dmap->numSlots + 1;
+
+  return dmap;
+}
+
+//
+// directmap_build
+//
+struct DirectMap *directmap_build(struct Database *db,
+                                  struct TableMeta *tablemeta, int column,
+                                  struct ColumnCache *cache,
+                                  struct TableFile *tablefile) {
+  if (db == NULL)
+    panic("db is NULL (directmap_build)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (directmap_build)");
+  if (cache == NULL && tablefile == NULL)
+    panic("cache and tablefile are NULL (directmap_build)");
+  if (tablemeta->columns[column].colType != COL_TYPE_INT)
+    panic("only int columns can be mapped (directmap_build)");
+
+  struct DirectMapHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!sidecar_stamp(&header.stamp, db, tablemeta, DIRECTMAP_MAGIC))
+    return NULL;
+
+  int numRecords = (cache != NULL) ? cache->numRows : tablefile->numRecords;
+
+  //
+  // (1) collect the keys, and find their range:
+  //
+  int32_t *keys = (int32_t *)malloc(sizeof(int32_t) * numRecords + 1);
+  bool *needed = (bool *)malloc(sizeof(bool) * tablemeta->numColumns);
+  struct FieldValue *values = (struct FieldValue *)malloc(
+      sizeof(struct FieldValue) * tablemeta->numColumns);
+  if (keys == NULL || needed == NULL || values == NULL)
+    panic("out of memory");
+
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    needed[i] = (i == column);
+  }
+
+  struct RecordDecoder *decoder =
+      (cache == NULL) ? decoder_create(tablemeta, needed) : NULL;
+
+  int minKey = 0;
+  int maxKey = 0;
+  for (int r = 0; r < numRecords; r++) {
+    if (cache != NULL)
+      colcache_decode(cache, r, needed, values);
+    else
+      decoder_decode(decoder, tablefile_record(tablefile, r), values);
+
+    keys[r] = values[column].value.i;
+    if (r == 0 || keys[r] < minKey)
+      minKey = keys[r];
+    if (r == 0 || keys[r] > maxKey)
+      maxKey = keys[r];
+  }
+
+  decoder_destroy(decoder);
+  free(values);
+  free(needed);
+
+  long long numSlots = (long long)maxKey - minKey + 1;
+  bool dense = isDense(numSlots, numRecords);
+
+  //
+  // (2) if the keys are dense, count the records with each key, and
+  // place each record # after those of the smaller keys --- a counting
+  // sort, which keeps the records of a key in record order:
+  //
+  int32_t *starts = NULL;
+  int32_t *recNums = NULL;
+  if (dense) {
+    starts = (int32_t *)malloc(sizeof(int32_t) * (numSlots + 1));
+    recNums = (int32_t *)malloc(sizeof(int32_t) * numRecords + 1);
+    if (starts == NULL || recNums == NULL)
+      panic("out of memory");
+    memset(starts, 0, sizeof(int32_t) * (numSlots + 1));
+
+    for (int r = 0; r < numRecords; r++) {
+      starts[keys[r] - minKey + 1]++;
+    }
+    for (long long s = 0; s < numSlots; s++) {
+      starts[s + 1] += starts[s];
+    }
+
+    // starts[s] is advanced past each record placed, and then restored
+    for (int r = 0; r < numRecords; r++) {
+      recNums[starts[keys[r] - minKey]] = r;
+      starts[keys[r] - minKey]++;
+    }
+    for (long long s = numSlots; s > 0; s--) {
+      starts[s] = starts[s - 1];
+    }
+    starts[0] = 0;
+  }
+
+  free(keys);
+
+  //
+  // (3) write to a temporary file and rename it into place:
+  //
+  header.stamp.numRecords = numRecords;
+  header.column = column;
+  header.dense = dense ? 1 : 0;
+  header.minKey = dense ? minKey : 0;
+  header.numSlots = dense ? (int32_t)numSlots : 0;
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  char mapPath[SIDECAR_MAX_PATH];
+  char tempPath[SIDECAR_MAX_PATH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(mapPath, db, tablemeta, ext);
+
+  bool written = false;
+  FILE *file = sidecar_create(mapPath, tempPath, &header.stamp);
+  if (file != NULL) {
+    fwrite(&header.column, sizeof(header) - sizeof(header.stamp), 1, file);
+    if (dense) {
+      fwrite(starts, sizeof(int32_t), numSlots + 1, file);
+      fwrite(recNums, sizeof(int32_t), numRecords, file);
+    }
+    written = sidecar_commit(file, tempPath, mapPath);
+  }
+
+  free(starts);
+  free(recNums);
+
+  if (!written)
+    return NULL;
+
+  return directmap_open(db, tablemeta, column);
+}
+
+//
+// directmap_close
+//
+void directmap_close(struct DirectMap *dmap) {
+  if (dmap == NULL)
+    return;
+
+  sidecar_unmap(dmap->data, dmap->size);
+  free(dmap);
+}
+
+//
+// directmap_find
+//
+void directmap_find(struct DirectMap *dmap, int key, int *first, int *last) {
+  long long slot = (long long)key - dmap->minKey;
+  if (slot < 0 || slot >= dmap->numSlots) { // outside the range: none
+    *first = 0;
+    *last = 0;
+    return;
+  }
+
+  *first = dmap->starts[slot];
+  *last = dmap->starts[slot + 1];
+}
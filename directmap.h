@@ -0,0 +1,99 @@
+/*directmap.h*/
+
+//
+// Project: Direct-address key maps for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+#include <stdint.h>  // int32_t
+
+#include "colcache.h"
+#include "database.h"
+#include "sidecar.h"
+#include "tablefile.h"
+
+//
+// A DirectMap is an index on one indexed int column of a table whose
+// keys are dense: the range from the smallest to the largest key has
+// at most DIRECTMAP_MAX_SLOTS_PER_RECORD slots per record, so the map
+// takes about as much space as a B+tree on the column, and not many
+// times the table itself. Stations.ID (40010..41700, 147 records), at
+// 11 slots per record, is too sparse, and so are the IDs of MovieLens.
+// The map is a flat array with one slot per key in the range; slot
+// key - minKey holds the position where the record #s with that key
+// begin in a second array, which lists every record #, grouped by key
+// and in record order within a key. Looking up key = value is then
+// two adjacent array loads, with no hashing and no search.
+//
+// The map is stored next to the table as "TABLE-NAME.COLUMN-NAME.dmap"
+// and mapped into memory. If the keys turn out not to be dense, only
+// that fact is stored, so the map isn't tried again.
+//
+#define DIRECTMAP_MAX_SLOTS_PER_RECORD 2
+
+struct DirectMap
+{
+  char        path[SIDECAR_MAX_PATH]; // name/name.column.dmap
+  const char* data;  // the mapped file
+  size_t      size;  // # of bytes in the file
+
+  int            column;     // index of the column in the table (0-based)
+  bool           dense;      // false => keys too sparse, no arrays
+  int            minKey;
+  int            numSlots;   // # of keys in the range minKey..maxKey
+  const int32_t* starts;     // pointer to ARRAY of numSlots+1 positions
+  const int32_t* recNums;    // pointer to ARRAY of record #s, by key
+};
+
+
+//
+// Functions:
+//
+
+//
+// directmap_open
+//
+// Opens and maps the direct-address map on the given column of the
+// table. Returns NULL if there is none, or if it does not match the
+// table's current .data file or meta-data.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling directmap_close().
+//
+struct DirectMap* directmap_open(struct Database* db,
+  struct TableMeta* tablemeta, int column);
+
+//
+// directmap_build
+//
+// Builds the direct-address map on the given int column of the table
+// in two passes over its keys, writes it, replacing any existing one,
+// and then opens it. The keys are read from the columnar cache if
+// there is one, otherwise decoded from the table file. Returns NULL
+// if the map could not be written.
+//
+struct DirectMap* directmap_build(struct Database* db,
+  struct TableMeta* tablemeta, int column, struct ColumnCache* cache,
+  struct TableFile* tablefile);
+
+//
+// directmap_close
+//
+// Unmaps the map and frees the memory associated with it.
+//
+void directmap_close(struct DirectMap* dmap);
+
+//
+// directmap_find
+//
+// Finds the record #s with the given key: they are recNums[*first]
+// through recNums[*last - 1], in record order. The map must be dense.
+//
+void directmap_find(struct DirectMap* dmap, int key, int* first, int* last);
@@ -18,160 +18,153 @@
 
 #include "analyzer.h"
 #include "ast.h"
+#include "colvec.h"
 #include "database.h"
 #include "parser.h"
 #include "resultset.h"
+#include "rsutil.h"
+#include "scan.h"
 #include "scanner.h"
 #include "tokenqueue.h"
 #include "util.h"
 
-// removes the quotes from the databuffer
-void removeQuotes(char *input) {
-  int len = strlen(input);
-  for (int i = 0; i < len - 2; i++) {
-    input[i] = input[i + 1]; // shifts all the characters in the string over by
-                             // 1
-  }
-  input[len - 2] =
-      '\0'; // adds a null terminator at the end of the shifted string
-}
+// marks the table column that the query column refers to (if any) as needed
+static void markNeeded(struct COLUMN *column, struct TableMeta *tablemeta,
+                       bool *needed) {
+  if (column == NULL)
+    return;
+  if (column->table != NULL && icmpStrings(column->table, tablemeta->name) != 0)
+    return; // a column of some other table
 
-// determines if the part of the databuffer is a string, int, or double
-int getType(char *input) {
-  char start = input[0];
-  if (start == '\"' || start == '\'') { // if the start of the of the string has
-                                        // quotes, it must be a string
-    return 1;
-  } else { // if the string doesn't have quotes, it must be an int or double
-    for (int i = 0; i < strlen(input);
-         i++) { // loops through the input, if it has a decimal it must be a
-                // double
-      start = input[i];
-      if (start == '.') {
-        return 2;
-      }
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    if (icmpStrings(tablemeta->columns[i].name, column->name) == 0) {
+      needed[i] = true;
     }
-    return 3; // if the loop makes it through the input without finding a
-              // string, it must be an int
   }
 }
 
-// checks if the value at the specified row and column index for columns of type
-// integer fulfill the requirements of the query
-bool found_row_int(int rowIndex, int colIndex, struct ResultSet *rs,
-                   struct EXPR *expr) {
-  int op = expr->operator; // gets the query operator
-
-  int rsInput = resultset_getInt(
-      rs, rowIndex, colIndex);      // resultset value and specified indices
-  int astInput = atoi(expr->value); // query value
+// determines which columns of the table the query refers to in its
+// select, join, where and order by clauses; returns an array of flags,
+// one per table column, which the caller must free
+static bool *findNeededColumns(struct SELECT *select,
+                               struct TableMeta *tablemeta) {
+  bool *needed = (bool *)malloc(sizeof(bool) * tablemeta->numColumns);
+  if (needed == NULL)
+    panic("out of memory");
 
-  // returns true if the query expression is true
-  if (op == 0) {
-    if (rsInput < astInput)
-      return true;
-  }
-  if (op == 1) {
-    if (rsInput <= astInput)
-      return true;
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    needed[i] = false;
   }
-  if (op == 2) {
-    if (rsInput > astInput)
-      return true;
+
+  for (struct COLUMN *column = select->columns; column != NULL;
+       column = column->next) {
+    markNeeded(column, tablemeta, needed);
   }
-  if (op == 3) {
-    if (rsInput >= astInput)
-      return true;
+  if (select->join != NULL) {
+    markNeeded(select->join->left, tablemeta, needed);
+    markNeeded(select->join->right, tablemeta, needed);
   }
-  if (op == 4) {
-    if (rsInput == astInput)
-      return true;
+  if (select->where != NULL) {
+    markNeeded(select->where->expr->column, tablemeta, needed);
   }
-  if (op == 5) {
-    if (rsInput != astInput)
-      return true;
+  if (select->orderby != NULL) {
+    markNeeded(select->orderby->column, tablemeta, needed);
   }
-  return false;
-}
-
-// checks if the value at the specified row and column index for columns of type
-// double fulfill the requirements of the query
-bool found_row_double(int rowIndex, int colIndex, struct ResultSet *rs,
-                      struct EXPR *expr) {
-  int op = expr->operator; // gets the query operator
 
-  double rsInput = resultset_getReal(
-      rs, rowIndex, colIndex);         // resultset value and specified indices
-  double astInput = atof(expr->value); // query value
+  return needed;
+}
 
-  // returns true if the query expression is true
-  if (op == 0) {
-    if (rsInput < astInput)
-      return true;
-  }
-  if (op == 1) {
-    if (rsInput <= astInput)
-      return true;
-  }
-  if (op == 2) {
-    if (rsInput > astInput)
-      return true;
+// returns the # of rows the scan needs to produce to answer the query,
+// or -1 if it needs them all; a limit can only end the scan early when
+// no function or ordering needs to see the other rows
+static int findScanLimit(struct SELECT *select) {
+  if (select->limit == NULL || select->orderby != NULL)
+    return -1;
+
+  for (struct COLUMN *column = select->columns; column != NULL;
+       column = column->next) {
+    if (column->function != NO_FUNCTION)
+      return -1;
   }
-  if (op == 3) {
-    if (rsInput >= astInput)
-      return true;
-  }
-  if (op == 4) {
-    if ((rsInput - astInput) < 0.00001)
-      return true;
-  }
-  if (op == 5) {
-    if (rsInput != astInput)
-      return true;
-  }
-  return false;
+
+  return select->limit->N;
 }
 
-// checks if the value at the specified row and column index for columns of type
-// string fulfill the requirements of the query
-bool found_row_string(int rowIndex, int colIndex, struct ResultSet *rs,
-                      struct EXPR *expr) {
-  int op = expr->operator; // gets the query operator
-
-  char *rsInput = resultset_getString(
-      rs, rowIndex, colIndex);  // resultset value and specified indices
-  char *astInput = expr->value; // query value
-  int comp =
-      strcasecmp(rsInput, astInput); // compares the strings and creates a
-                                     // numeric value based off the comparison
-  free(rsInput); // frees the allocated copy of the resultset data
-
-  // returns true if the query expression is true
-  if (op == 0) {
-    if (comp < 0)
-      return true;
+// computes a query that selects nothing but one COUNT, MIN, MAX, SUM
+// or AVG without materializing the rows: a COUNT doesn't depend on
+// the values in the rows, the MIN or MAX of an indexed column can
+// come from its index, and otherwise the function is computed right
+// on the scanned column's typed array. Returns a resultset with the
+// value, as if the function had been applied to the scanned rows
+// (like resultset_applyFunction, no rows means no value at all), or
+// NULL if it must be applied to a resultset after all
+static struct ResultSet *aggregateRows(struct Database *db,
+                                       struct ScanPlan *plan,
+                                       struct SELECT *select) {
+  struct COLUMN *column = select->columns;
+  if (column == NULL || column->next != NULL)
+    return NULL;
+
+  int colNum = 0;
+  for (int i = 0; i < plan->tablemeta->numColumns; i++) {
+    if (icmpStrings(plan->tablemeta->columns[i].name, column->name) == 0)
+      colNum = i;
   }
-  if (op == 1) {
-    if (comp < 0 || comp == 0)
-      return true;
-  }
-  if (op == 2) {
-    if (comp > 0)
-      return true;
-  }
-  if (op == 3) {
-    if (comp > 0 || comp == 0)
-      return true;
-  }
-  if (op == 4) {
-    if (comp == 0)
-      return true;
+  struct ColumnMeta *colMeta = &plan->tablemeta->columns[colNum];
+
+  int numRows = 0;
+  struct RSValue value;
+  value.valueType = COL_TYPE_INT;
+  value.value.i = 0;
+  struct ColumnVectors *vectors = NULL;
+
+  if (column->function == COUNT_FUNCTION) {
+    numRows = scan_count(db, plan);
+    value.value.i = numRows;
+  } else if ((column->function == MIN_FUNCTION ||
+              column->function == MAX_FUNCTION) &&
+             scan_indexMinMax(db, plan, colNum,
+                              column->function == MAX_FUNCTION,
+                              &value.value.i, &numRows)) {
+    // answered by the index
+  } else if (column->function == MIN_FUNCTION ||
+             column->function == MAX_FUNCTION ||
+             ((column->function == SUM_FUNCTION ||
+               column->function == AVG_FUNCTION) &&
+              colMeta->colType != COL_TYPE_STRING)) {
+    int vecCol = 0; // the vectors only have the needed columns
+    for (int i = 0; i < colNum; i++) {
+      if (plan->columns[i])
+        vecCol++;
+    }
+
+    vectors = scan_vectors(db, plan);
+    numRows = vectors->numRows;
+    if (numRows > 0)
+      colvec_computeFunction(vectors, vecCol, numRows, column->function,
+                             &value);
+  } else {
+    return NULL;
   }
-  if (op == 5) {
-    if (comp != 0)
-      return true;
+
+  struct ResultSet *rs = resultset_create();
+  if (numRows == 0) {
+    resultset_insertColumn(rs, 1, plan->tablemeta->name, colMeta->name,
+                           NO_FUNCTION, colMeta->colType);
+  } else {
+    resultset_insertColumn(rs, 1, plan->tablemeta->name, colMeta->name,
+                           column->function, value.valueType);
+    int row = resultset_addRow(rs);
+    if (value.valueType == COL_TYPE_INT)
+      resultset_putInt(rs, row, 1, value.value.i);
+    else if (value.valueType == COL_TYPE_REAL)
+      resultset_putReal(rs, row, 1, value.value.r);
+    else
+      resultset_putString(rs, row, 1, value.value.s);
   }
-  return false;
+
+  colvec_destroy(vectors); // after the string, if any, is copied
+  return rs;
 }
 
 //
@@ -202,18 +195,10 @@ void execute_query(struct Database *db, struct QUERY *query) {
   // (1) we need a pointer to the table meta data, so find it:
   //
   struct TableMeta *tablemeta = NULL;
-  struct ResultSet *rs = resultset_create();
   for (int t = 0; t < db->numTables; t++) {
     if (icmpStrings(db->tables[t].name, select->table) == 0) // found it:
     {
       tablemeta = &db->tables[t];
-      for (int i = 1; i < tablemeta->numColumns + 1;
-           i++) { // loops through each tablemeta and create a resultset column
-                  // with matching information
-        resultset_insertColumn(rs, i, tablemeta->name,
-                               tablemeta->columns[i - 1].name, NO_FUNCTION,
-                               tablemeta->columns[i - 1].colType);
-      }
       break;
     }
   }
@@ -221,214 +206,166 @@ void execute_query(struct Database *db, struct QUERY *query) {
   assert(tablemeta != NULL);
 
   //
-  // (2) open the table's data file
-  //
-  // the table exists within a sub-directory under the executable
-  // where the directory has the same name as the database, and with
-  // a "TABLE-NAME.data" filename within that sub-directory:
+  // (2) scan the table's data into a resultset with a column for each
+  // column the query refers to, keeping only the rows that satisfy the
+  // where clause of the query (if any). A query that only wants one
+  // COUNT, MIN, MAX, SUM or AVG gets its answer without a resultset of
+  // the rows when possible:
   //
-  char path[(2 * DATABASE_MAX_ID_LENGTH) + 10];
-
-  strcpy(path, db->name); // name/name.data
-  strcat(path, "/");
-  strcat(path, tablemeta->name);
-  strcat(path, ".data");
-
-  FILE *datafile = fopen(path, "r");
-  if (datafile == NULL) // unable to open:
-  {
-    printf("**INTERNAL ERROR: table's data file '%s' not found.\n", path);
-    panic("execution halted");
-    exit(-1);
+  struct ScanPlan plan;
+  plan.tablemeta = tablemeta;
+  plan.columns = findNeededColumns(select, tablemeta);
+  plan.where = select->where;
+  plan.limit = findScanLimit(select);
+
+  // the scanned rows' strings stay in the vectors' arenas, which the
+  // resultset borrows them from, so from here on its columns and rows
+  // are deleted, and it is destroyed, via the colvec_* functions
+  struct ColumnVectors *vectors = NULL;
+  struct ResultSet *rs = aggregateRows(db, &plan, select);
+  bool aggregated = (rs != NULL);
+  if (!aggregated) {
+    vectors = scan_vectors(db, &plan);
+    rs = colvec_toResultSet(vectors, plan.limit);
   }
+  free(plan.columns);
 
   //
-  // (3) allocate a buffer for input, and start reading the data:
+  // (3) project the resultset onto the query's columns. The columns
+  // are looked up by name in a hash table, once, rather than by
+  // walking the list once per query column, and are then usually
+  // reordered by relinking them just once:
   //
-  int dataBufferSize =
-      tablemeta->recordSize + 3; // ends with $\n + null terminator
-  char *dataBuffer = (char *)malloc(sizeof(char) * dataBufferSize);
-  if (dataBuffer == NULL)
+  int numNames = 0;
+  for (struct COLUMN *temp = select->columns; temp != NULL;
+       temp = temp->next) {
+    numNames++;
+  }
+
+  char **names = (char **)malloc(sizeof(char *) * (numNames + 1));
+  int *positions = (int *)malloc(sizeof(int) * (numNames + 1));
+  int *kept = (int *)malloc(sizeof(int) * (rs->numCols + 1));
+  if (names == NULL || positions == NULL || kept == NULL)
     panic("out of memory");
 
-  int rowCount = 1;
-  while (true) {
-    fgets(dataBuffer, dataBufferSize, datafile);
+  int n = 0;
+  for (struct COLUMN *temp = select->columns; temp != NULL;
+       temp = temp->next) {
+    names[n] = temp->name;
+    n++;
+  }
 
-    if (feof(datafile)) // end of the data file, we're done
-      break;
+  // deletes columns not specified in the query, noting where each of
+  // the others ends up (kept[i] is 0 for a deleted column)
+  rsutil_findColumns(rs, names, numNames, positions);
+  for (int i = 0; i < rs->numCols; i++) {
+    kept[i] = 0;
+  }
+  for (int i = 0; i < numNames; i++) {
+    if (positions[i] != -1)
+      kept[positions[i] - 1] = 1;
+  }
 
-    // breaks up the databuffer by adding null terminators in the blank spaces
-    int length = strlen(dataBuffer);
-    char *cp = dataBuffer; // create a pointer to the databuffer to work with
-    for (int i = 0; i < length; i++) {
-      if (*cp == '\"') { // if the databuffer has a quote, loop through and
-                         // advance the pointer until another quote is found
-        cp++;
-        i++;
-        while (*cp != '\"') {
-          cp++;
-          i++;
-        }
-      } else if (*cp == '\'') { // if the databuffer has a single quote, loop
-                                // through and advance the pointer until another
-                                // single quote is found
-        cp++;
-        i++;
-        while (*cp != '\'') {
-          cp++;
-          i++;
-        }
-      }
-      if (*cp ==
-          ' ') { // if a blank space is found, add a null string terminator
-        *cp = '\0';
-      }
-      cp++;
+  int numCols = rs->numCols;
+  int position = 1;
+  for (int i = 0; i < numCols; i++) {
+    if (kept[i] == 0) { // if the column in the resultset was not found in the
+                        // query, delete the column
+      colvec_deleteColumn(vectors, rs, position);
+    } else {
+      kept[i] = position;
+      position++;
     }
+  }
 
-    // adds the parts of the databuffer to their appropriate columns
-    rowCount = resultset_addRow(rs);
-    char *temp = dataBuffer; // create a pointer to the databuffer to work with
-    for (int i = 0; i < tablemeta->numColumns; i++) {
-      int type = getType(temp); // determines wether the part of the databuffer
-                                // is a string, int, or double
-      bool removedQuotes = false; // boolean to keep track of whether the part
-                                  // of the databuffer has quotes (is a string)
-
-      if (type == 1) {      // string with quotes
-        removeQuotes(temp); // removes the quotes
-        removedQuotes = true;
-        resultset_putString(rs, rowCount, i + 1, temp);
-      }
-      if (type == 2) { // double
-        resultset_putReal(rs, rowCount, i + 1, atof(temp));
-      }
-      if (type == 3) { // int
-        resultset_putInt(rs, rowCount, i + 1, atoi(temp));
-      }
+  for (int i = 0; i < numNames; i++) {
+    if (positions[i] != -1)
+      positions[i] = kept[positions[i] - 1];
+  }
 
-      char *index = temp; // creates a pointer of temp to work with
-      while (
-          *index !=
-          '\0') { // advance the pointer until the next null terminator is found
-        index++;
-      }
-      if (removedQuotes) { // if quotes were removed, advanced the pointer 2
-                           // more spaces to account for the removed quotes
-        index += 2;
-      }
-      index++;
-      temp = index; // set the temp back
-    }
+  // reorders the resultset columns to match the query: when each query
+  // column names a different column, those come first, in query order,
+  // followed by the rest, and the columns are relinked all at once
+  numCols = rs->numCols;
+  int *order = (int *)malloc(sizeof(int) * (numCols + 1));
+  bool *placed = (bool *)malloc(sizeof(bool) * (numCols + 1));
+  if (order == NULL || placed == NULL)
+    panic("out of memory");
+  for (int i = 0; i <= numCols; i++) {
+    placed[i] = false;
   }
-  free(dataBuffer);
 
-  // evaluates the where clause of a query
-  if (select->where != NULL) {
-    struct EXPR *expr = select->where->expr;
-    struct COLUMN *exprCol = expr->column;
-
-    struct RSColumn *currcol = rs->columns;
-    int colNum = resultset_findColumn(
-        rs, 1, exprCol->table,
-        exprCol->name); // finds theindex of the column that matches the where
-                        // part of the query
-    for (int i = 1; i < colNum; i++) { // loops to the correct index
-      currcol = currcol->next;
+  bool distinct = true;
+  n = 0;
+  for (int i = 0; i < numNames && distinct; i++) {
+    if (positions[i] == -1 || placed[positions[i]]) {
+      distinct = false;
+    } else {
+      placed[positions[i]] = true;
+      order[n] = positions[i];
+      n++;
     }
+  }
 
-    for (int i = rs->numRows; i > 0;
-         i--) { // loops through every row of the column and evaluates the value
-                // agains the query, deleting the row if it doesn't
-      if (currcol->coltype == COL_TYPE_INT) {
-        if (!(found_row_int(i, colNum, rs, expr))) { // compares the ints
-          resultset_deleteRow(rs, i);
-        }
-      }
-      if (currcol->coltype == COL_TYPE_REAL) {
-        if (!(found_row_double(i, colNum, rs, expr))) { // compares the doubles
-          resultset_deleteRow(rs, i);
-        }
-      }
-      if (currcol->coltype == COL_TYPE_STRING) {
-        if (!(found_row_string(i, colNum, rs, expr))) { // compares the strings
-          resultset_deleteRow(rs, i);
-        }
+  if (distinct) {
+    for (int i = 1; i <= numCols; i++) {
+      if (!placed[i]) {
+        order[n] = i;
+        n++;
       }
     }
-  }
-
-  // deletes columns not specified in the query
-  bool found = false;
-  struct RSColumn *RSCol = rs->columns;
-  for (int i = 0; i < rs->numCols;
-       i++) {      // loop through for each column in the result set
-    found = false; // tracks if the column was found
-    char *RSColName = RSCol->colName;
+    rsutil_permuteColumns(rs, order);
+  } else { // a column named twice, or not at all, moves one at a time
     struct COLUMN *temp = select->columns;
-    while (temp != NULL) { // loops through all query parts
-      if (strcasecmp(RSColName, temp->name) ==
-          0) { // checksif the column in the resultset matches one found in a
-               // query
-        found = true;
+    int colIndex = 1;
+    while (temp != NULL) { // loop through ast to reorder resultset columns
+      int initialIndex = 1;
+      struct RSColumn *RSCol = rs->columns;
+      for (int i = 1; i < rs->numCols + 1;
+           i++) { // loops through the result set and finds the index it
+                  // should be moved to
+        if (strcasecmp(RSCol->colName, temp->name) == 0) {
+          initialIndex = i;
+        }
+        RSCol = RSCol->next;
       }
+      resultset_moveColumn(rs, initialIndex, colIndex); // moves the column
       temp = temp->next;
-    }
-    if (!found) { // if the column in the resultset was not found in the query,
-                  // delete the column
-      RSCol = RSCol->next;
-      resultset_deleteColumn(rs, i + 1);
-      i--;
-    } else {
-      RSCol = RSCol->next;
+      colIndex++;
     }
   }
 
-  // reorders the resultset columns to match the query
-  struct COLUMN *temp = select->columns;
-  int colIndex = 1;
-  while (temp != NULL) { // loop through ast to reorder resultset columns
-    int initialIndex = 1;
-    struct RSColumn *RSCol = rs->columns;
-    for (int i = 1; i < rs->numCols + 1;
-         i++) { // loops through the result set and finds the index it should be
-                // moved to
-      if (strcasecmp(RSCol->colName, temp->name) == 0) {
-        initialIndex = i;
-      }
-      RSCol = RSCol->next;
-    }
-    resultset_moveColumn(rs, initialIndex, colIndex); // moves the column
-    temp = temp->next;
-    colIndex++;
-  }
+  free(placed);
+  free(order);
+  free(kept);
+  free(positions);
+  free(names);
 
   // applies a function to the resultset columns if the ast columns has a
   // function
   struct COLUMN *temp2 = select->columns;
-  colIndex = 1;
+  int colIndex = 1;
   while (temp2 != NULL) {        // loops through all the columns in the query
-    if (temp2->function != -1) { // checks if the query has a function and if so
-                                 // it applies the function to the resultset
-      resultset_applyFunction(rs, temp2->function, colIndex);
+    if (temp2->function != -1 &&
+        !aggregated) { // checks if the query has a function and if so
+                       // it applies the function to the resultset
+      colvec_applyFunction(vectors, rs, temp2->function, colIndex);
     }
     temp2 = temp2->next;
     colIndex++;
   }
 
-  // applies limit to the resultset by deleting any rows past the limit
+  // applies limit to the resultset by deleting any rows past the limit,
+  // all at once rather than one row at a time
   struct LIMIT *limit = select->limit;
-  if (limit != NULL) {
-    while (limit->N !=
-           rs->numRows) { // deletes the rows starting from the last row until
-                          // the number of rows matches the limit in the query
-      resultset_deleteRow(rs, rs->numRows);
-    }
-  }
+  if (limit != NULL)
+    colvec_truncateRows(vectors, rs, limit->N);
 
   resultset_print(rs);
-  resultset_destroy(rs);
+
+  // the borrowed strings are freed all at once, with their arenas
+  colvec_destroyResultSet(vectors, rs);
+  colvec_destroy(vectors);
   analyzer_destroy(query);
   //
   // done!
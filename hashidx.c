@@ -0,0 +1,249 @@
+/*hashidx.c*/
+
+//
+// Project: Hash indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int32_t, uint32_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memset, strcpy, strcat
+
+#include "colcache.h"
+#include "database.h"
+#include "decoder.h"
+#include "hashidx.h"
+#include "sidecar.h"
+#include "tablefile.h"
+#include "util.h"
+
+#define HASHIDX_MAGIC "SSQLHSH2"
+
+//
+// On-disk layout: a HashHeader, followed, if the keys are unique, by
+// the array of numSlots slots.
+//
+struct HashHeader
+{
+  struct SidecarStamp stamp;  // the .data file the index was built from
+  int32_t             column;
+  int32_t             colType;
+  int32_t             numSlots;
+  int32_t             unique;  // 0 => a key repeats, no slots follow
+};
+
+// builds ".COLUMN-NAME.hash", the extension of the index's sidecar
+static void buildExtension(char *ext, struct TableMeta *tablemeta, int column) {
+  strcpy(ext, ".");
+  strcat(ext, tablemeta->columns[column].name);
+  strcat(ext, ".hash");
+}
+
+// returns the slot where the search for key starts; keys are often
+// consecutive, so the bits are mixed first to spread them out
+static int homeSlot(int key, int numSlots) {
+  uint32_t h = (uint32_t)key;
+  h ^= h >> 16;
+  h *= 0x45d9f3bU;
+  h ^= h >> 16;
+  return (int)(h & (uint32_t)(numSlots - 1));
+}
+
+//
+// hashidx_open
+//
+struct HashIndex *hashidx_open(struct Database *db, struct TableMeta *tablemeta,
+                               int column) {
+  if (db == NULL)
+    panic("db is NULL (hashidx_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (hashidx_open)");
+
+  struct SidecarStamp stamp;
+  if (!sidecar_stamp(&stamp, db, tablemeta, HASHIDX_MAGIC))
+    return NULL;
+
+  struct HashIndex *hashidx =
+      (struct HashIndex *)malloc(sizeof(struct HashIndex));
+  if (hashidx == NULL)
+    panic("out of memory");
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(hashidx->path, db, tablemeta, ext);
+
+  // the index must have been built from the current .data file:
+  hashidx->data = sidecar_map(hashidx->path, &stamp, &hashidx->size);
+  if (hashidx->data == NULL) { // no index yet, or stale
+    free(hashidx);
+    return NULL;
+  }
+
+  //
+  // ... and with the current meta-data:
+  //
+  const struct HashHeader *header = (const struct HashHeader *)hashidx->data;
+
+  bool valid = sizeof(struct HashHeader) <= hashidx->size &&
+               header->column == column &&
+               header->colType == tablemeta->columns[column].colType &&
+               (header->unique == 0 ||
+                (header->numSlots > 0 &&
+                 (header->numSlots & (header->numSlots - 1)) == 0 &&
+                 sizeof(struct HashHeader) +
+                         (size_t)header->numSlots * sizeof(struct HashSlot) <=
+                     hashidx->size));
+
+  if (!valid) { // damaged, the caller will rebuild it
+    sidecar_unmap(hashidx->data, hashidx->size);
+    free(hashidx);
+    return NULL;
+  }
+
+  hashidx->column = column;
+  hashidx->unique = (header->unique != 0);
+  hashidx->numSlots = hashidx->unique ? header->numSlots : 0;
+  hashidx->slots =
+      hashidx->unique
+          ? (const struct HashSlot *)(hashidx->data + sizeof(struct HashHeader))
+          : NULL;
+
+  return hashidx;
+}
+
+//
+// hashidx_build
+//
+struct HashIndex *hashidx_build(struct Database *db, struct TableMeta *tablemeta,
+                                int column, struct ColumnCache *cache,
+                                struct TableFile *tablefile) {
+  if (db == NULL)
+    panic("db is NULL (hashidx_build)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (hashidx_build)");
+  if (cache == NULL && tablefile == NULL)
+    panic("cache and tablefile are NULL (hashidx_build)");
+  if (tablemeta->columns[column].colType != COL_TYPE_INT)
+    panic("only int columns can be indexed (hashidx_build)");
+
+  struct HashHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!sidecar_stamp(&header.stamp, db, tablemeta, HASHIDX_MAGIC))
+    return NULL;
+
+  int numRecords = (cache != NULL) ? cache->numRows : tablefile->numRecords;
+
+  int numSlots = 16;
+  while (numSlots < 2 * numRecords)
+    numSlots *= 2;
+
+  struct HashSlot *slots =
+      (struct HashSlot *)malloc(sizeof(struct HashSlot) * numSlots);
+  bool *needed = (bool *)malloc(sizeof(bool) * tablemeta->numColumns);
+  struct FieldValue *values = (struct FieldValue *)malloc(
+      sizeof(struct FieldValue) * tablemeta->numColumns);
+  if (slots == NULL || needed == NULL || values == NULL)
+    panic("out of memory");
+
+  for (int s = 0; s < numSlots; s++) {
+    slots[s].key = 0;
+    slots[s].recNum = -1;
+  }
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    needed[i] = (i == column);
+  }
+
+  //
+  // one pass over the records, inserting each key:
+  //
+  struct RecordDecoder *decoder =
+      (cache == NULL) ? decoder_create(tablemeta, needed) : NULL;
+  bool unique = true;
+
+  for (int r = 0; unique && r < numRecords; r++) {
+    if (cache != NULL)
+      colcache_decode(cache, r, needed, values);
+    else
+      decoder_decode(decoder, tablefile_record(tablefile, r), values);
+
+    int key = values[column].value.i;
+    int s = homeSlot(key, numSlots);
+    while (slots[s].recNum >= 0 && slots[s].key != key)
+      s = (s + 1) & (numSlots - 1);
+
+    if (slots[s].recNum >= 0) // the key is already there
+      unique = false;
+
+    slots[s].key = key;
+    slots[s].recNum = r;
+  }
+
+  decoder_destroy(decoder);
+  free(values);
+  free(needed);
+
+  //
+  // write to a temporary file and rename it into place; if a key
+  // repeats, only the header is written, so the column isn't tried
+  // again until the .data file changes:
+  //
+  bool written = false;
+  char indexPath[SIDECAR_MAX_PATH];
+
+  header.column = column;
+  header.colType = COL_TYPE_INT;
+  header.numSlots = unique ? numSlots : 0;
+  header.unique = unique ? 1 : 0;
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  char tempPath[SIDECAR_MAX_PATH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(indexPath, db, tablemeta, ext);
+
+  FILE *file = sidecar_create(indexPath, tempPath, &header.stamp);
+  if (file != NULL) {
+    fwrite(&header.column, sizeof(header) - sizeof(header.stamp), 1, file);
+    if (unique)
+      fwrite(slots, sizeof(struct HashSlot), numSlots, file);
+    written = sidecar_commit(file, tempPath, indexPath);
+  }
+
+  free(slots);
+
+  if (!written)
+    return NULL;
+
+  return hashidx_open(db, tablemeta, column);
+}
+
+//
+// hashidx_close
+//
+void hashidx_close(struct HashIndex *hashidx) {
+  if (hashidx == NULL)
+    return;
+
+  sidecar_unmap(hashidx->data, hashidx->size);
+  free(hashidx);
+}
+
+//
+// hashidx_find
+//
+int hashidx_find(struct HashIndex *hashidx, int key) {
+  int s = homeSlot(key, hashidx->numSlots);
+
+  // at least half the slots are empty, so this always ends
+  while (hashidx->slots[s].recNum >= 0) {
+    if (hashidx->slots[s].key == key)
+      return hashidx->slots[s].recNum;
+    s = (s + 1) & (hashidx->numSlots - 1);
+  }
+
+  return -1;
+}
@@ -0,0 +1,100 @@
+/*hashidx.h*/
+
+//
+// Project: Hash indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+#include <stdint.h>  // int32_t
+
+#include "colcache.h"
+#include "database.h"
+#include "sidecar.h"
+#include "tablefile.h"
+
+//
+// A HashIndex is an open-addressing hash table on one unique-indexed
+// int column of a table, mapping each key to the # of the record
+// that holds it. It is stored next to the table as
+// "TABLE-NAME.COLUMN-NAME.hash" and mapped into memory, so looking up
+// a key is one probe into the mapping --- usually a single slot,
+// with linear probing past the occasional collision --- followed by
+// one record fetch.
+//
+// The table has a power-of-2 # of slots, at least twice the # of
+// records, so probe sequences stay short. If the column turns out to
+// have a key more than once, despite the meta-data, only a header
+// marking it as not unique is written, so the index isn't built
+// again (and again fails) until the .data file changes.
+//
+struct HashSlot
+{
+  int32_t key;
+  int32_t recNum;  // -1 => empty slot
+};
+
+struct HashIndex
+{
+  char        path[SIDECAR_MAX_PATH]; // name/name.column.hash
+  const char* data;  // the mapped file
+  size_t      size;  // # of bytes in the file
+
+  int                    column;    // index of the column in the table
+  bool                   unique;    // false => a key repeats, no slots
+  int                    numSlots;  // a power of 2
+  const struct HashSlot* slots;     // pointer to ARRAY of slots
+};
+
+
+//
+// Functions:
+//
+
+//
+// hashidx_open
+//
+// Opens and maps the hash index on the given column of the table.
+// Returns NULL if there is none, or if it does not match the table's
+// current .data file or meta-data.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling hashidx_close().
+//
+struct HashIndex* hashidx_open(struct Database* db, struct TableMeta* tablemeta,
+  int column);
+
+//
+// hashidx_build
+//
+// Builds the hash index on the given int column of the table in one
+// pass over its records, writes it, replacing any existing one, and
+// then opens it. The keys are read from the columnar cache if there
+// is one, otherwise decoded from the table file. Returns NULL if the
+// index could not be written. If a key appears more than once, the
+// index is marked as not unique and has no slots; then the column
+// isn't really unique, and a B+tree must be used.
+//
+struct HashIndex* hashidx_build(struct Database* db, struct TableMeta* tablemeta,
+  int column, struct ColumnCache* cache, struct TableFile* tablefile);
+
+//
+// hashidx_close
+//
+// Unmaps the index and frees the memory associated with it.
+//
+void hashidx_close(struct HashIndex* hashidx);
+
+//
+// hashidx_find
+//
+// Returns the # of the record whose key is the given one, or -1 if
+// there is none. The index must be unique.
+//
+int hashidx_find(struct HashIndex* hashidx, int key);
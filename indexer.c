@@ -0,0 +1,271 @@
+/*indexer.c*/
+
+//
+// Project: Background index builds for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <pthread.h> // pthread_create, pthread_join
+#include <stdbool.h> // true, false
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bitmap.h"
+#include "btree.h"
+#include "colcache.h"
+#include "database.h"
+#include "directmap.h"
+#include "hashidx.h"
+#include "indexer.h"
+#include "options.h"
+#include "tablefile.h"
+#include "trigram.h"
+#include "util.h"
+
+enum IndexKind
+{
+  INDEX_BTREE = 0,
+  INDEX_HASH,
+  INDEX_DIRECT,
+  INDEX_BITMAP,
+  INDEX_TRIGRAM
+};
+
+//
+// One index to build, and whether it has been built (or skipped)
+//
+struct IndexJob
+{
+  struct TableMeta* tablemeta;
+  int               column;
+  enum IndexKind    kind;
+  bool              done;      // guarded by lock
+};
+
+//
+// The indexer's state; there is one open database at a time
+//
+static struct Database *database = NULL;
+static struct IndexJob *jobs = NULL;
+static int numJobs = 0;
+static int nextJob = 0;       // guarded by lock, as is stop
+static bool stop = false;
+static pthread_t *threads = NULL;
+static int numThreads = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// returns true if the given index of the column exists and matches
+// the table's current .data file and meta-data
+static bool isBuilt(struct Database *db, struct TableMeta *tablemeta,
+                    int column, enum IndexKind kind) {
+  if (kind == INDEX_BTREE) {
+    struct BTree *btree = btree_open(db, tablemeta, column);
+    btree_close(btree);
+    return btree != NULL;
+  } else if (kind == INDEX_HASH) {
+    struct HashIndex *hashidx = hashidx_open(db, tablemeta, column);
+    hashidx_close(hashidx);
+    return hashidx != NULL;
+  } else if (kind == INDEX_DIRECT) {
+    struct DirectMap *dmap = directmap_open(db, tablemeta, column);
+    directmap_close(dmap);
+    return dmap != NULL;
+  } else if (kind == INDEX_BITMAP) {
+    struct BitmapIndex *bitmap = bitmap_open(db, tablemeta, column);
+    bitmap_close(bitmap);
+    return bitmap != NULL;
+  } else {
+    struct TrigramIndex *trigram = trigram_open(db, tablemeta, column);
+    trigram_close(trigram);
+    return trigram != NULL;
+  }
+}
+
+// adds a job for the given index of the column, unless it is built
+static void addJob(struct Database *db, struct TableMeta *tablemeta,
+                   int column, enum IndexKind kind) {
+  if (isBuilt(db, tablemeta, column, kind))
+    return;
+
+  jobs = (struct IndexJob *)realloc(jobs,
+                                    sizeof(struct IndexJob) * (numJobs + 1));
+  if (jobs == NULL)
+    panic("out of memory");
+
+  jobs[numJobs].tablemeta = tablemeta;
+  jobs[numJobs].column = column;
+  jobs[numJobs].kind = kind;
+  jobs[numJobs].done = false;
+  numJobs++;
+}
+
+// builds the job's index from the table's columnar cache if there is
+// a valid one, otherwise from its .data file
+static void buildIndex(struct IndexJob *job) {
+  struct TableMeta *tablemeta = job->tablemeta;
+  struct ColumnCache *cache = NULL;
+  struct TableFile *tablefile = NULL;
+
+  if (options_get()->useColumnCache)
+    cache = colcache_open(database, tablemeta);
+  if (cache == NULL)
+    tablefile = tablefile_open(database, tablemeta);
+  if (cache == NULL && tablefile == NULL) // the scan will report it
+    return;
+
+  if (job->kind == INDEX_BTREE) {
+    btree_close(
+        btree_build(database, tablemeta, job->column, cache, tablefile));
+  } else if (job->kind == INDEX_HASH) {
+    hashidx_close(
+        hashidx_build(database, tablemeta, job->column, cache, tablefile));
+  } else if (job->kind == INDEX_DIRECT) {
+    directmap_close(
+        directmap_build(database, tablemeta, job->column, cache, tablefile));
+  } else if (job->kind == INDEX_BITMAP) {
+    bitmap_close(
+        bitmap_build(database, tablemeta, job->column, cache, tablefile));
+  } else {
+    trigram_close(
+        trigram_build(database, tablemeta, job->column, cache, tablefile));
+  }
+
+  colcache_close(cache);
+  tablefile_close(tablefile);
+}
+
+// worker thread: builds jobs in order until there are none left, or
+// until the indexer is stopped
+static void *indexWorker(void *arg) {
+  (void)arg; // the jobs are shared, so there is nothing to pass
+
+  while (true) {
+    pthread_mutex_lock(&lock);
+    int j = nextJob;
+    nextJob++;
+    bool stopped = stop;
+    pthread_mutex_unlock(&lock);
+
+    if (stopped || j >= numJobs)
+      break;
+
+    buildIndex(&jobs[j]);
+
+    pthread_mutex_lock(&lock);
+    jobs[j].done = true;
+    pthread_mutex_unlock(&lock);
+  }
+
+  return NULL;
+}
+
+//
+// indexer_start
+//
+void indexer_start(struct Database *db) {
+  if (db == NULL)
+    panic("db is NULL (indexer_start)");
+  if (threads != NULL)
+    panic("indexer already started (indexer_start)");
+
+  struct Options *options = options_get();
+  if (!options->useIndexes || !options->useBackgroundIndexes)
+    return;
+
+  //
+  // (1) one job per index that is missing or stale, in table order,
+  // so the indexes of a table tend to be ready at about the same time:
+  //
+  for (int t = 0; t < db->numTables; t++) {
+    struct TableMeta *tablemeta = &db->tables[t];
+
+    for (int c = 0; c < tablemeta->numColumns; c++) {
+      struct ColumnMeta *colMeta = &tablemeta->columns[c];
+      if (colMeta->indexType == COL_NON_INDEXED)
+        continue;
+
+      if (colMeta->colType == COL_TYPE_INT) {
+        addJob(db, tablemeta, c, INDEX_BTREE);
+        if (colMeta->indexType == COL_UNIQUE_INDEXED)
+          addJob(db, tablemeta, c, INDEX_HASH);
+        if (options->useDirectMaps)
+          addJob(db, tablemeta, c, INDEX_DIRECT);
+      } else if (colMeta->colType == COL_TYPE_STRING) {
+        addJob(db, tablemeta, c, INDEX_BITMAP);
+        addJob(db, tablemeta, c, INDEX_TRIGRAM);
+      }
+    }
+  }
+
+  if (numJobs == 0)
+    return;
+
+  //
+  // (2) build them on a pool of worker threads, one job at a time each:
+  //
+  database = db;
+  nextJob = 0;
+  stop = false;
+
+  numThreads = options->numThreads;
+  if (numThreads > numJobs)
+    numThreads = numJobs;
+
+  threads = (pthread_t *)malloc(sizeof(pthread_t) * numThreads);
+  if (threads == NULL)
+    panic("out of memory");
+
+  for (int t = 0; t < numThreads; t++) {
+    if (pthread_create(&threads[t], NULL, indexWorker, NULL) != 0)
+      panic("unable to create index thread (indexer_start)");
+  }
+}
+
+//
+// indexer_pending
+//
+bool indexer_pending(struct TableMeta *tablemeta, int column) {
+  bool pending = false;
+
+  pthread_mutex_lock(&lock);
+  for (int j = 0; j < numJobs && !pending; j++) {
+    pending = (jobs[j].tablemeta == tablemeta && jobs[j].column == column &&
+               !jobs[j].done);
+  }
+  pthread_mutex_unlock(&lock);
+
+  return pending;
+}
+
+//
+// indexer_stop
+//
+void indexer_stop(void) {
+  if (threads == NULL)
+    return;
+
+  // builds that have started are finished, so no index is left half
+  // written; the rest are skipped, rather than keeping the user waiting,
+  // and the next session finds those indexes still missing
+  pthread_mutex_lock(&lock);
+  stop = true;
+  pthread_mutex_unlock(&lock);
+
+  for (int t = 0; t < numThreads; t++) {
+    pthread_join(threads[t], NULL);
+  }
+
+  pthread_mutex_lock(&lock);
+  free(jobs);
+  jobs = NULL;
+  numJobs = 0;
+  pthread_mutex_unlock(&lock);
+
+  free(threads);
+  threads = NULL;
+  numThreads = 0;
+  database = NULL;
+}
@@ -0,0 +1,63 @@
+/*indexer.h*/
+
+//
+// Project: Background index builds for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+
+#include "database.h"
+
+//
+// The indexer builds the indexes of a database in the background,
+// so the first query on a large table doesn't wait for them. When
+// the database is opened, every column the meta-data marks as
+// indexed is checked for index files that are missing, or stale
+// because the .data file changed: a B+tree, a direct-address map
+// (and, if unique, a hash index) for an int column, a bitmap and a
+// trigram index for a string column. Each missing index is one job,
+// and a pool of worker threads builds the jobs in parallel.
+//
+// While a column's indexes are being built, queries on it don't
+// build them too; they scan the table instead. An index is renamed
+// into place once it is completely written, so the first query
+// after that finds and uses it.
+//
+
+
+//
+// Functions:
+//
+
+//
+// indexer_start
+//
+// Looks for missing or stale indexes of the database's indexed
+// columns, and starts building them on background threads. Does
+// nothing if indexes are disabled, or if all of them are up to date.
+//
+// NOTE: the database must stay open until indexer_stop() is called.
+//
+void indexer_start(struct Database* db);
+
+//
+// indexer_pending
+//
+// Returns true if an index on the given column of the table is
+// still being built in the background.
+//
+bool indexer_pending(struct TableMeta* tablemeta, int column);
+
+//
+// indexer_stop
+//
+// Waits for the indexes being built right now to be finished, skips
+// the rest, and stops the background threads.
+//
+void indexer_stop(void);
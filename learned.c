@@ -0,0 +1,355 @@
+/*learned.c*/
+
+//
+// Project: Learned indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <float.h>   // DBL_MAX
+#include <limits.h>  // INT_MAX
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int32_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memset, strcpy, strcat
+
+#include "btree.h"
+#include "database.h"
+#include "learned.h"
+#include "sidecar.h"
+#include "util.h"
+
+#define LEARNED_MAGIC "SSQLLRN2"
+
+//
+// On-disk layout: a LearnedHeader, followed, if the keys could be
+// fitted, by the numSegments segments in order of their first keys.
+//
+struct LearnedHeader
+{
+  struct SidecarStamp stamp;  // the .data file the index was built from
+  int32_t             column;
+  int32_t             numEntries;
+  int32_t             numSegments;
+  int32_t             maxError;
+  int32_t             fitted;  // 0 => the fit failed, no segments follow
+  int32_t             unused;
+};
+
+// builds ".COLUMN-NAME.lrn", the extension of the index's sidecar
+static void buildExtension(char *ext, struct TableMeta *tablemeta, int column) {
+  strcpy(ext, ".");
+  strcat(ext, tablemeta->columns[column].name);
+  strcat(ext, ".lrn");
+}
+
+// returns the entry # the segment predicts for the key, which may be
+// outside of the entries
+static long long predict(const struct LearnedSegment *segment, int key) {
+  double entry = segment->firstEntry +
+                 segment->slope * ((double)key - (double)segment->firstKey);
+  long long predicted = (long long)entry; // rounded down, even if < 0
+  if (predicted > entry)
+    predicted--;
+  return predicted;
+}
+
+// returns the segment that covers the key: the last one whose first
+// key is <= key, or NULL if the key is smaller than every key
+static const struct LearnedSegment *findSegment(struct LearnedIndex *learned,
+                                                int key) {
+  int lo = 0;
+  int hi = learned->numSegments;
+  while (lo < hi) { // the # of segments whose first key is <= key
+    int mid = lo + (hi - lo) / 2;
+    if (learned->segments[mid].firstKey <= key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (lo > 0) ? &learned->segments[lo - 1] : NULL;
+}
+
+//
+// learned_open
+//
+struct LearnedIndex *learned_open(struct Database *db,
+                                  struct TableMeta *tablemeta, int column) {
+  if (db == NULL)
+    panic("db is NULL (learned_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (learned_open)");
+
+  struct SidecarStamp stamp;
+  if (!sidecar_stamp(&stamp, db, tablemeta, LEARNED_MAGIC))
+    return NULL;
+
+  struct LearnedIndex *learned =
+      (struct LearnedIndex *)malloc(sizeof(struct LearnedIndex));
+  if (learned == NULL)
+    panic("out of memory");
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(learned->path, db, tablemeta, ext);
+
+  // the index must have been built from the current .data file:
+  learned->data = sidecar_map(learned->path, &stamp, &learned->size);
+  if (learned->data == NULL) { // no index yet, or stale
+    free(learned);
+    return NULL;
+  }
+
+  //
+  // ... and with the current meta-data:
+  //
+  const struct LearnedHeader *header =
+      (const struct LearnedHeader *)learned->data;
+
+  bool valid = sizeof(struct LearnedHeader) <= learned->size &&
+               header->column == column &&
+               tablemeta->columns[column].colType == COL_TYPE_INT &&
+               header->numEntries == header->stamp.numRecords &&
+               header->numSegments >= 0 &&
+               (header->fitted != 0 || header->numSegments == 0) &&
+               header->maxError >= 0 &&
+               header->maxError <= LEARNED_MAX_ERROR &&
+               sizeof(struct LearnedHeader) +
+                       (size_t)header->numSegments *
+                           sizeof(struct LearnedSegment) <=
+                   learned->size;
+
+  if (!valid) { // damaged, the caller will rebuild it
+    sidecar_unmap(learned->data, learned->size);
+    free(learned);
+    return NULL;
+  }
+
+  learned->column = column;
+  learned->fitted = (header->fitted != 0);
+  learned->numEntries = header->numEntries;
+  learned->numSegments = header->numSegments;
+  learned->maxError = header->maxError;
+  learned->segments = (const struct LearnedSegment *)(learned->data +
+                                                      sizeof(struct LearnedHeader));
+
+  return learned;
+}
+
+//
+// learned_build
+//
+struct LearnedIndex *learned_build(struct Database *db,
+                                   struct TableMeta *tablemeta,
+                                   struct BTree *btree) {
+  if (db == NULL)
+    panic("db is NULL (learned_build)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (learned_build)");
+  if (btree == NULL)
+    panic("btree is NULL (learned_build)");
+
+  struct LearnedHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!sidecar_stamp(&header.stamp, db, tablemeta, LEARNED_MAGIC))
+    return NULL;
+
+  int numEntries = btree->numEntries;
+  if (header.stamp.numRecords != numEntries) // the B+tree is stale
+    return NULL;
+
+  //
+  // (1) fit the segments greedily, to the first entry # of each
+  // distinct key: a segment starts at a key, and every following key
+  // narrows the range of slopes that keep all of the segment's
+  // predictions within the error bound, until the range is empty and
+  // a new segment starts. A little of the bound is kept in reserve
+  // for rounding:
+  //
+  const double bound = LEARNED_MAX_ERROR - 1;
+
+  int numSegments = 0;
+  int capacity = 16;
+  struct LearnedSegment *segments =
+      (struct LearnedSegment *)malloc(sizeof(struct LearnedSegment) * capacity);
+  if (segments == NULL)
+    panic("out of memory");
+
+  double minSlope = 0.0;
+  double maxSlope = DBL_MAX;
+  for (int e = 0; e < numEntries; e++) {
+    int key = btree_key(btree, e);
+    if (e > 0 && key == btree_key(btree, e - 1)) // not the first entry
+      continue;
+
+    if (numSegments > 0) { // does the key fit the current segment?
+      struct LearnedSegment *segment = &segments[numSegments - 1];
+      double dk = (double)key - (double)segment->firstKey;
+      double low = (e - bound - segment->firstEntry) / dk;
+      double high = (e + bound - segment->firstEntry) / dk;
+
+      if (low <= maxSlope && high >= minSlope) {
+        if (low > minSlope)
+          minSlope = low;
+        if (high < maxSlope)
+          maxSlope = high;
+        continue;
+      }
+
+      // no: the segment ends with the slope in the middle of its range
+      segment->slope =
+          (maxSlope == DBL_MAX) ? minSlope : (minSlope + maxSlope) / 2;
+    }
+
+    if (numSegments == capacity) { // start a new segment
+      capacity *= 2;
+      segments = (struct LearnedSegment *)realloc(
+          segments, sizeof(struct LearnedSegment) * capacity);
+      if (segments == NULL)
+        panic("out of memory");
+    }
+    segments[numSegments].firstKey = key;
+    segments[numSegments].unused = 0;
+    segments[numSegments].slope = 0.0;
+    segments[numSegments].firstEntry = e;
+    numSegments++;
+    minSlope = 0.0;
+    maxSlope = DBL_MAX;
+  }
+
+  if (numSegments > 0) { // the last segment ends with the last key
+    struct LearnedSegment *segment = &segments[numSegments - 1];
+    segment->slope =
+        (maxSlope == DBL_MAX) ? minSlope : (minSlope + maxSlope) / 2;
+  }
+
+  //
+  // (2) validate: predict every distinct key, and measure the error:
+  //
+  int maxError = 0;
+  int s = 0;
+  for (int e = 0; e < numEntries; e++) {
+    int key = btree_key(btree, e);
+    if (e > 0 && key == btree_key(btree, e - 1))
+      continue;
+
+    while (s + 1 < numSegments && segments[s + 1].firstKey <= key)
+      s++;
+
+    long long error = predict(&segments[s], key) - e;
+    if (error < 0)
+      error = -error;
+    if (error > maxError)
+      maxError = (error > LEARNED_MAX_ERROR) ? LEARNED_MAX_ERROR + 1
+                                             : (int)error;
+  }
+
+  // if the fit is wrong, only that fact is written, so that it isn't
+  // fitted again (and again wrong) by every query on the column
+  bool fitted = (maxError <= LEARNED_MAX_ERROR);
+
+  //
+  // (3) write to a temporary file and rename it into place:
+  //
+  header.column = btree->column;
+  header.numEntries = numEntries;
+  header.numSegments = fitted ? numSegments : 0;
+  header.maxError = fitted ? maxError : 0;
+  header.fitted = fitted ? 1 : 0;
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  char indexPath[SIDECAR_MAX_PATH];
+  char tempPath[SIDECAR_MAX_PATH + 16];
+  buildExtension(ext, tablemeta, btree->column);
+  sidecar_path(indexPath, db, tablemeta, ext);
+
+  bool written = false;
+  FILE *file = sidecar_create(indexPath, tempPath, &header.stamp);
+  if (file != NULL) {
+    fwrite(&header.column, sizeof(header) - sizeof(header.stamp), 1, file);
+    if (fitted)
+      fwrite(segments, sizeof(struct LearnedSegment), numSegments, file);
+    written = sidecar_commit(file, tempPath, indexPath);
+  }
+
+  free(segments);
+
+  if (!written)
+    return NULL;
+
+  return learned_open(db, tablemeta, btree->column);
+}
+
+//
+// learned_close
+//
+void learned_close(struct LearnedIndex *learned) {
+  if (learned == NULL)
+    return;
+
+  sidecar_unmap(learned->data, learned->size);
+  free(learned);
+}
+
+//
+// learned_lowerBound
+//
+int learned_lowerBound(struct LearnedIndex *learned, struct BTree *btree,
+                       int key) {
+  int numEntries = btree->numEntries;
+  const struct LearnedSegment *segment = findSegment(learned, key);
+  if (segment == NULL) // smaller than every key
+    return 0;
+
+  //
+  // the answer is within maxError of the prediction for keys in the
+  // index; for other keys, the window is widened, doubling each time,
+  // until the entry before it is < key and the one at its end >= key:
+  //
+  long long predicted = predict(segment, key);
+  long long lo = predicted - learned->maxError;
+  long long hi = predicted + learned->maxError + 1;
+  if (lo < 0)
+    lo = 0;
+  if (lo > numEntries)
+    lo = numEntries;
+  if (hi > numEntries)
+    hi = numEntries;
+  if (hi < lo)
+    hi = lo;
+
+  long long step = learned->maxError + 1;
+  while (lo > 0 && btree_key(btree, (int)lo - 1) >= key) {
+    lo = (lo > step) ? lo - step : 0;
+    step *= 2;
+  }
+  step = learned->maxError + 1;
+  while (hi < numEntries && btree_key(btree, (int)hi) < key) {
+    hi = (hi + step < numEntries) ? hi + step : numEntries;
+    step *= 2;
+  }
+
+  // then the first entry >= key in [lo, hi), or hi if there is none
+  while (lo < hi) {
+    long long mid = lo + (hi - lo) / 2;
+    if (btree_key(btree, (int)mid) < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (int)lo;
+}
+
+//
+// learned_upperBound
+//
+int learned_upperBound(struct LearnedIndex *learned, struct BTree *btree,
+                       int key) {
+  if (key == INT_MAX)
+    return btree->numEntries;
+
+  return learned_lowerBound(learned, btree, key + 1);
+}
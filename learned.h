@@ -0,0 +1,122 @@
+/*learned.h*/
+
+//
+// Project: Learned indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+#include <stdint.h>  // int32_t
+
+#include "btree.h"
+#include "database.h"
+#include "sidecar.h"
+
+//
+// A LearnedIndex replaces the search down a B+tree with arithmetic.
+// The entries of a B+tree are numbered in key order, so the # of the
+// first entry with a given key is a non-decreasing function of the
+// key; for dense keys like Stations.ID (40010, 40020, ...) it is
+// nearly a straight line. The learned index approximates it with a
+// few linear segments, each predicting an entry # within maxError
+// of the true one for every key in the index; a lookup picks the
+// segment, evaluates it, and searches the few entries around the
+// prediction in the B+tree's leaves. (When the table is sorted on
+// the key, as Stations is, the entry # is the record # itself.)
+//
+// The segments are fitted so that no prediction is off by more than
+// LEARNED_MAX_ERROR entries, and every prediction is checked against
+// the B+tree before the index is written; if any is off by more, only
+// a header marking the column as not fitted is written, so the fit
+// isn't tried again until the .data file changes. The index is stored
+// next to the table as "TABLE-NAME.COLUMN-NAME.lrn" --- a few dozen
+// bytes per segment, against 8 bytes per record for the B+tree.
+//
+#define LEARNED_MAX_ERROR 16
+
+struct LearnedSegment
+{
+  int32_t firstKey;   // the smallest key the segment covers
+  int32_t unused;
+  double  slope;      // entry # = firstEntry + slope * (key - firstKey)
+  double  firstEntry;
+};
+
+struct LearnedIndex
+{
+  char        path[SIDECAR_MAX_PATH]; // name/name.column.lrn
+  const char* data;  // the mapped file
+  size_t      size;  // # of bytes in the file
+
+  int column;       // index of the column in the table (0-based)
+  bool fitted;      // false => the fit failed, no segments
+  int numEntries;   // # of entries in the B+tree
+  int numSegments;
+  int maxError;     // the largest error of any prediction, in entries
+  const struct LearnedSegment* segments; // pointer to ARRAY, by firstKey
+};
+
+
+//
+// Functions:
+//
+
+//
+// learned_open
+//
+// Opens and maps the learned index on the given column of the table.
+// Returns NULL if there is none, or if it does not match the table's
+// current .data file or meta-data.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling learned_close().
+//
+struct LearnedIndex* learned_open(struct Database* db,
+  struct TableMeta* tablemeta, int column);
+
+//
+// learned_build
+//
+// Fits the learned index to the keys of the given B+tree, which must
+// be up to date, validates its predictions, writes it, replacing any
+// existing one, and then opens it. Returns NULL if the index could
+// not be written. If a prediction is off by more than
+// LEARNED_MAX_ERROR entries, the index is marked as not fitted and
+// has no segments; then the B+tree must be searched instead.
+//
+struct LearnedIndex* learned_build(struct Database* db,
+  struct TableMeta* tablemeta, struct BTree* btree);
+
+//
+// learned_close
+//
+// Unmaps the index and frees the memory associated with it.
+//
+void learned_close(struct LearnedIndex* learned);
+
+//
+// learned_lowerBound
+//
+// Returns the # of the first entry of the B+tree whose key is >= key,
+// or numEntries if there is none, just like btree_lowerBound(). The
+// prediction's neighborhood is searched first; the search widens
+// only if the answer lies outside of it. The index must be fitted.
+//
+int learned_lowerBound(struct LearnedIndex* learned, struct BTree* btree,
+  int key);
+
+//
+// learned_upperBound
+//
+// Returns the # of the first entry of the B+tree whose key is > key,
+// or numEntries if there is none, just like btree_upperBound(). The
+// index must be fitted.
+//
+int learned_upperBound(struct LearnedIndex* learned, struct BTree* btree,
+  int key);
@@ -22,6 +22,7 @@
 #include "ast.h"
 #include "database.h"
 #include "execute.h"
+#include "indexer.h"
 #include "parser.h"
 #include "resultset.h"
 #include "scanner.h"
@@ -60,6 +61,8 @@ int main()
     exit(-1);
   }
 
+  indexer_start(db); // builds missing indexes in the background
+
   //
   // print the schema:
   //
@@ -106,17 +109,11 @@ int main()
       } 
       else {
         //
-        // print AST and output first 5 lines of the table
-        // given in the FROM clause of the query:
+        // execute the query and print its result:
         //
         // print_ast(query);
 
-        //
-        // TODO:
-        //
-        // execute_query(???;
-
-        analyzer_destroy(query); // done with query, free memory
+        execute_query(db, query); // also frees the query's memory
       }
     }// else
   }// while
@@ -124,6 +121,7 @@ int main()
   //
   // done!
   //
+  indexer_stop(); // before the database goes away
   database_close(db);
 
   return 0;
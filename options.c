@@ -0,0 +1,80 @@
+/*options.c*/
+
+//
+// Project: Execution options for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <pthread.h> // pthread_once
+#include <stdbool.h> // true, false
+#include <stdio.h>
+#include <stdlib.h> // getenv, atoi
+#include <unistd.h> // sysconf
+
+#include "options.h"
+
+static struct Options options;
+static pthread_once_t initialized = PTHREAD_ONCE_INIT;
+
+// returns the value of the environment variable as a true/false flag,
+// or the default if the variable is not set
+static bool getFlag(char *name, bool defaultValue) {
+  char *value = getenv(name);
+  if (value == NULL || value[0] == '\0')
+    return defaultValue;
+
+  return atoi(value) != 0;
+}
+
+// returns the value of the environment variable as a number, or the
+// default if the variable is not set
+static int getNumber(char *name, int defaultValue) {
+  char *value = getenv(name);
+  if (value == NULL || value[0] == '\0')
+    return defaultValue;
+
+  return atoi(value);
+}
+
+// reads the options from the environment; called exactly once, by
+// whichever thread calls options_get() first
+static void readOptions(void) {
+  options.useColumnCache =
+      getFlag("SIMPLESQL_COLCACHE", OPTIONS_DEFAULT_COLUMN_CACHE);
+
+  options.numThreads = getNumber("SIMPLESQL_THREADS", OPTIONS_DEFAULT_THREADS);
+  if (options.numThreads <= 0) // one per CPU
+    options.numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (options.numThreads <= 0) // unknown # of CPUs
+    options.numThreads = 1;
+
+  options.useZoneMaps =
+      getFlag("SIMPLESQL_ZONEMAPS", OPTIONS_DEFAULT_ZONE_MAPS);
+  options.useReadAhead =
+      getFlag("SIMPLESQL_READAHEAD", OPTIONS_DEFAULT_READ_AHEAD);
+  options.useIndexes = getFlag("SIMPLESQL_INDEXES", OPTIONS_DEFAULT_INDEXES);
+  options.useBackgroundIndexes =
+      getFlag("SIMPLESQL_BGINDEXES", OPTIONS_DEFAULT_BG_INDEXES);
+  options.usePermutations =
+      getFlag("SIMPLESQL_PERMUTATIONS", OPTIONS_DEFAULT_PERMUTATIONS);
+  options.useCoveringIndexes =
+      getFlag("SIMPLESQL_COVERING", OPTIONS_DEFAULT_COVERING);
+  options.useLearnedIndexes =
+      getFlag("SIMPLESQL_LEARNED", OPTIONS_DEFAULT_LEARNED);
+  options.useDirectMaps =
+      getFlag("SIMPLESQL_DIRECTMAPS", OPTIONS_DEFAULT_DIRECT_MAPS);
+}
+
+//
+// options_get
+//
+struct Options *options_get(void) {
+  // scan and index threads may be the first to ask, so the options are
+  // read under pthread_once rather than behind a plain flag
+  pthread_once(&initialized, readOptions);
+
+  return &options;
+}
@@ -0,0 +1,58 @@
+/*options.h*/
+
+//
+// Project: Execution options for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+
+//
+// Options that control how queries are executed. Each option has
+// a default below, which can be overridden by setting the given
+// environment variable before starting the program, e.g.
+//
+//   SIMPLESQL_COLCACHE=0 ./a.out
+//
+struct Options
+{
+  bool useColumnCache;       // SIMPLESQL_COLCACHE: read/write <table>.col files
+  int  numThreads;           // SIMPLESQL_THREADS: # of threads to scan a table
+  bool useZoneMaps;          // SIMPLESQL_ZONEMAPS: read/write <table>.zmap files
+  bool useReadAhead;         // SIMPLESQL_READAHEAD: read .data files ahead of scans
+  bool useIndexes;           // SIMPLESQL_INDEXES: read/write <table>.<column>.idx files
+  bool useBackgroundIndexes; // SIMPLESQL_BGINDEXES: build indexes at startup
+  bool usePermutations;      // SIMPLESQL_PERMUTATIONS: sort non-indexed columns
+  bool useCoveringIndexes;   // SIMPLESQL_COVERING: include columns in B+trees
+  bool useLearnedIndexes;    // SIMPLESQL_LEARNED: search B+trees by prediction
+  bool useDirectMaps;        // SIMPLESQL_DIRECTMAPS: map dense keys to records
+};
+
+#define OPTIONS_DEFAULT_COLUMN_CACHE true
+#define OPTIONS_DEFAULT_THREADS      0    // 0 => one per online CPU
+#define OPTIONS_DEFAULT_ZONE_MAPS    true
+#define OPTIONS_DEFAULT_READ_AHEAD   true
+#define OPTIONS_DEFAULT_INDEXES      true
+#define OPTIONS_DEFAULT_BG_INDEXES   true
+#define OPTIONS_DEFAULT_PERMUTATIONS true
+#define OPTIONS_DEFAULT_COVERING     true
+#define OPTIONS_DEFAULT_LEARNED      true
+#define OPTIONS_DEFAULT_DIRECT_MAPS  true
+
+
+//
+// Functions:
+//
+
+//
+// options_get
+//
+// Returns the options in effect; the environment is read the first
+// time this is called. Safe to call from any thread.
+//
+struct Options* options_get(void);
@@ -0,0 +1,274 @@
+/*permutation.c*/
+
+//
+// Project: Sorted permutation indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int32_t
+#include <stdio.h>
+#include <stdlib.h> // qsort
+#include <string.h> // memset, strcpy, strcat
+
+#include "colcache.h"
+#include "database.h"
+#include "decoder.h"
+#include "permutation.h"
+#include "sidecar.h"
+#include "tablefile.h"
+#include "util.h"
+
+#define PERMUTATION_MAGIC "SSQLPRM1"
+
+//
+// On-disk layout: a PermutationHeader, followed by the numEntries
+// sorted values (doubles), followed by their numEntries record #s.
+//
+struct PermutationHeader
+{
+  struct SidecarStamp stamp;  // the .data file the index was built from
+  int32_t             column;
+  int32_t             colType;
+  int32_t             numEntries;
+  int32_t             unused;
+};
+
+//
+// An entry while the index is built; sorted by value, then record #
+//
+struct Entry
+{
+  double  value;
+  int32_t recNum;
+};
+
+// builds ".COLUMN-NAME.perm", the extension of the index's sidecar
+static void buildExtension(char *ext, struct TableMeta *tablemeta, int column) {
+  strcpy(ext, ".");
+  strcat(ext, tablemeta->columns[column].name);
+  strcat(ext, ".perm");
+}
+
+// orders entries by value, and entries with the same value by record #
+static int compareEntries(const void *a, const void *b) {
+  const struct Entry *e1 = (const struct Entry *)a;
+  const struct Entry *e2 = (const struct Entry *)b;
+  if (e1->value != e2->value)
+    return (e1->value < e2->value) ? -1 : 1;
+  return (e1->recNum < e2->recNum) ? -1 : (e1->recNum > e2->recNum);
+}
+
+//
+// permutation_open
+//
+struct Permutation *permutation_open(struct Database *db,
+                                     struct TableMeta *tablemeta,
+                                     int column) {
+  if (db == NULL)
+    panic("db is NULL (permutation_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (permutation_open)");
+
+  struct SidecarStamp stamp;
+  if (!sidecar_stamp(&stamp, db, tablemeta, PERMUTATION_MAGIC))
+    return NULL;
+
+  struct Permutation *perm =
+      (struct Permutation *)malloc(sizeof(struct Permutation));
+  if (perm == NULL)
+    panic("out of memory");
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(perm->path, db, tablemeta, ext);
+
+  // the index must have been built from the current .data file:
+  perm->data = sidecar_map(perm->path, &stamp, &perm->size);
+  if (perm->data == NULL) { // no index yet, or stale
+    free(perm);
+    return NULL;
+  }
+
+  //
+  // ... and with the current meta-data:
+  //
+  const struct PermutationHeader *header =
+      (const struct PermutationHeader *)perm->data;
+
+  bool valid = sizeof(struct PermutationHeader) <= perm->size &&
+               header->column == column &&
+               header->colType == tablemeta->columns[column].colType &&
+               header->numEntries == header->stamp.numRecords &&
+               sizeof(struct PermutationHeader) +
+                       (size_t)header->numEntries *
+                           (sizeof(double) + sizeof(int32_t)) <=
+                   perm->size;
+
+  if (!valid) { // damaged, the caller will rebuild it
+    sidecar_unmap(perm->data, perm->size);
+    free(perm);
+    return NULL;
+  }
+
+  perm->column = column;
+  perm->numEntries = header->numEntries;
+  perm->values =
+      (const double *)(perm->data + sizeof(struct PermutationHeader));
+  perm->recNums = (const int32_t *)(perm->values + perm->numEntries);
+
+  return perm;
+}
+
+//
+// permutation_build
+//
+struct Permutation *permutation_build(struct Database *db,
+                                      struct TableMeta *tablemeta, int column,
+                                      struct ColumnCache *cache,
+                                      struct TableFile *tablefile) {
+  if (db == NULL)
+    panic("db is NULL (permutation_build)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (permutation_build)");
+  if (cache == NULL && tablefile == NULL)
+    panic("cache and tablefile are NULL (permutation_build)");
+
+  int colType = tablemeta->columns[column].colType;
+  if (colType != COL_TYPE_INT && colType != COL_TYPE_REAL)
+    panic("only int and real columns can be sorted (permutation_build)");
+
+  struct PermutationHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!sidecar_stamp(&header.stamp, db, tablemeta, PERMUTATION_MAGIC))
+    return NULL;
+
+  int numEntries = (cache != NULL) ? cache->numRows : tablefile->numRecords;
+
+  //
+  // (1) collect the value of every record, and sort them:
+  //
+  struct Entry *entries =
+      (struct Entry *)malloc(sizeof(struct Entry) * numEntries + 1);
+  bool *needed = (bool *)malloc(sizeof(bool) * tablemeta->numColumns);
+  struct FieldValue *values = (struct FieldValue *)malloc(
+      sizeof(struct FieldValue) * tablemeta->numColumns);
+  if (entries == NULL || needed == NULL || values == NULL)
+    panic("out of memory");
+
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    needed[i] = (i == column);
+  }
+
+  struct RecordDecoder *decoder =
+      (cache == NULL) ? decoder_create(tablemeta, needed) : NULL;
+
+  for (int r = 0; r < numEntries; r++) {
+    if (cache != NULL)
+      colcache_decode(cache, r, needed, values);
+    else
+      decoder_decode(decoder, tablefile_record(tablefile, r), values);
+
+    entries[r].value = (colType == COL_TYPE_INT) ? values[column].value.i
+                                                 : values[column].value.r;
+    entries[r].recNum = r;
+  }
+
+  decoder_destroy(decoder);
+  free(values);
+  free(needed);
+
+  qsort(entries, numEntries, sizeof(struct Entry), compareEntries);
+
+  //
+  // (2) split the entries into the two arrays:
+  //
+  double *sortedValues = (double *)malloc(sizeof(double) * numEntries + 1);
+  int32_t *recNums = (int32_t *)malloc(sizeof(int32_t) * numEntries + 1);
+  if (sortedValues == NULL || recNums == NULL)
+    panic("out of memory");
+
+  for (int e = 0; e < numEntries; e++) {
+    sortedValues[e] = entries[e].value;
+    recNums[e] = entries[e].recNum;
+  }
+
+  free(entries);
+
+  //
+  // (3) write to a temporary file and rename it into place:
+  //
+  header.stamp.numRecords = numEntries;
+  header.column = column;
+  header.colType = colType;
+  header.numEntries = numEntries;
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  char indexPath[SIDECAR_MAX_PATH];
+  char tempPath[SIDECAR_MAX_PATH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(indexPath, db, tablemeta, ext);
+
+  bool written = false;
+  FILE *file = sidecar_create(indexPath, tempPath, &header.stamp);
+  if (file != NULL) {
+    fwrite(&header.column, sizeof(header) - sizeof(header.stamp), 1, file);
+    fwrite(sortedValues, sizeof(double), numEntries, file);
+    fwrite(recNums, sizeof(int32_t), numEntries, file);
+    written = sidecar_commit(file, tempPath, indexPath);
+  }
+
+  free(sortedValues);
+  free(recNums);
+
+  if (!written)
+    return NULL;
+
+  return permutation_open(db, tablemeta, column);
+}
+
+//
+// permutation_close
+//
+void permutation_close(struct Permutation *perm) {
+  if (perm == NULL)
+    return;
+
+  sidecar_unmap(perm->data, perm->size);
+  free(perm);
+}
+
+//
+// permutation_lowerBound
+//
+int permutation_lowerBound(struct Permutation *perm, double value) {
+  int lo = 0;
+  int hi = perm->numEntries;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (perm->values[mid] < value)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+//
+// permutation_upperBound
+//
+int permutation_upperBound(struct Permutation *perm, double value) {
+  int lo = 0;
+  int hi = perm->numEntries;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (perm->values[mid] <= value)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
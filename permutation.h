@@ -0,0 +1,99 @@
+/*permutation.h*/
+
+//
+// Project: Sorted permutation indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+#include <stdint.h>  // int32_t
+
+#include "colcache.h"
+#include "database.h"
+#include "sidecar.h"
+#include "tablefile.h"
+
+//
+// A Permutation is a secondary index on one non-indexed int or real
+// column of a table: the column's values, sorted, each paired with
+// the # of the record that holds it. The records matching a range
+// predicate such as Year >= 2000 are then a range of entries, found
+// by binary search, and only those records are read from the table,
+// each at its fixed offset in the .data file.
+//
+// It is stored next to the table as "TABLE-NAME.COLUMN-NAME.perm" and
+// mapped into memory, as two arrays: the sorted values, as doubles
+// (ints are exact as doubles), and their record #s. Entries with the
+// same value are in record order.
+//
+struct Permutation
+{
+  char        path[SIDECAR_MAX_PATH]; // name/name.column.perm
+  const char* data;  // the mapped file
+  size_t      size;  // # of bytes in the file
+
+  int            column;      // index of the column in the table (0-based)
+  int            numEntries;  // one per record
+  const double*  values;      // pointer to ARRAY of values, ascending
+  const int32_t* recNums;     // pointer to ARRAY of their record #s
+};
+
+
+//
+// Functions:
+//
+
+//
+// permutation_open
+//
+// Opens and maps the permutation index on the given column of the
+// table. Returns NULL if there is none, or if it does not match the
+// table's current .data file or meta-data.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling permutation_close().
+//
+struct Permutation* permutation_open(struct Database* db,
+  struct TableMeta* tablemeta, int column);
+
+//
+// permutation_build
+//
+// Builds the permutation index on the given int or real column of the
+// table, writes it, replacing any existing one, and then opens it.
+// The values are read from the columnar cache if there is one,
+// otherwise decoded from the table file. Returns NULL if the index
+// could not be written.
+//
+struct Permutation* permutation_build(struct Database* db,
+  struct TableMeta* tablemeta, int column, struct ColumnCache* cache,
+  struct TableFile* tablefile);
+
+//
+// permutation_close
+//
+// Unmaps the index and frees the memory associated with it.
+//
+void permutation_close(struct Permutation* perm);
+
+//
+// permutation_lowerBound
+//
+// Returns the # of the first entry whose value is >= value, or
+// numEntries if there is none.
+//
+int permutation_lowerBound(struct Permutation* perm, double value);
+
+//
+// permutation_upperBound
+//
+// Returns the # of the first entry whose value is > value, or
+// numEntries if there is none.
+//
+int permutation_upperBound(struct Permutation* perm, double value);
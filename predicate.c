@@ -0,0 +1,178 @@
+/*predicate.c*/
+
+//
+// Project: Where clause predicates for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <ctype.h>   // tolower
+#include <stdbool.h> // true, false
+#include <stdio.h>
+#include <stdlib.h> // atoi, atof
+
+#include "ast.h"
+#include "database.h"
+#include "decoder.h"
+#include "predicate.h"
+#include "util.h"
+
+// compares the string field s, of length len, to the null-terminated
+// string value, ignoring case; returns a value < 0, 0 or > 0 just like
+// strcasecmp would
+static int compareString(const char *s, int len, const char *value) {
+  for (int i = 0; i < len; i++) {
+    int c1 = tolower((unsigned char)s[i]);
+    int c2 = tolower((unsigned char)value[i]);
+    if (c1 != c2) // includes reaching the end of value first
+      return c1 - c2;
+  }
+  return (value[len] == '\0') ? 0 : -tolower((unsigned char)value[len]);
+}
+
+// returns true if the string field s, of length len, matches the
+// null-terminated LIKE pattern, ignoring case: % matches any sequence
+// of chars (including none), and _ matches exactly one char
+static bool matchesLike(const char *s, int len, const char *pattern) {
+  int i = 0;
+  const char *star = NULL; // the last % seen, and where its match ends
+  int starEnd = 0;
+
+  while (i < len) {
+    if (*pattern == '%') {
+      star = pattern++;
+      starEnd = i;
+    } else if (*pattern != '\0' &&
+               (*pattern == '_' || tolower((unsigned char)*pattern) ==
+                                       tolower((unsigned char)s[i]))) {
+      pattern++;
+      i++;
+    } else if (star != NULL) { // let the last % match one more char
+      pattern = star + 1;
+      starEnd++;
+      i = starEnd;
+    } else {
+      return false;
+    }
+  }
+
+  while (*pattern == '%')
+    pattern++;
+  return *pattern == '\0';
+}
+
+// returns true if the result of a comparison satisfies the operator,
+// where comp < 0, == 0 or > 0 means the field is less than, equal to,
+// or greater than the literal
+static bool satisfies(int op, int comp) {
+  if (op == EXPR_LT) {
+    return comp < 0;
+  }
+  if (op == EXPR_LTE) {
+    return comp <= 0;
+  }
+  if (op == EXPR_GT) {
+    return comp > 0;
+  }
+  if (op == EXPR_GTE) {
+    return comp >= 0;
+  }
+  if (op == EXPR_EQUAL) {
+    return comp == 0;
+  }
+  if (op == EXPR_NOT_EQUAL) {
+    return comp != 0;
+  }
+  return false;
+}
+
+//
+// predicate_init
+//
+void predicate_init(struct Predicate *pred, struct TableMeta *tablemeta,
+                    struct EXPR *expr) {
+  if (pred == NULL || tablemeta == NULL || expr == NULL)
+    panic("one or more parameters are NULL (predicate_init)");
+
+  pred->column = -1;
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    if (icmpStrings(tablemeta->columns[i].name, expr->column->name) == 0) {
+      pred->column = i;
+      break;
+    }
+  }
+  if (pred->column < 0)
+    panic("where clause column not found in table (predicate_init)");
+
+  pred->colType = tablemeta->columns[pred->column].colType;
+  pred->operator = expr->operator;
+  pred->intValue = atoi(expr->value); // literal in the column's type
+  pred->realValue = atof(expr->value);
+  pred->stringValue = expr->value;
+}
+
+//
+// predicate_matches
+//
+bool predicate_matches(struct Predicate *pred, struct FieldValue *field) {
+  if (pred->colType == COL_TYPE_INT) {
+    int value = field->value.i;
+    return satisfies(pred->operator,
+                     (value < pred->intValue) ? -1 : (value > pred->intValue));
+  }
+
+  if (pred->colType == COL_TYPE_REAL) {
+    double value = field->value.r;
+    if (pred->operator == EXPR_EQUAL) // reals are equal when close enough
+      return (value - pred->realValue) < 0.00001;
+
+    return satisfies(pred->operator, (value < pred->realValue)   ? -1
+                                     : (value > pred->realValue) ? 1
+                                                                 : 0);
+  }
+
+  if (pred->operator == EXPR_LIKE)
+    return matchesLike(field->value.str.s, field->value.str.len,
+                       pred->stringValue);
+
+  return satisfies(pred->operator, compareString(field->value.str.s,
+                                                 field->value.str.len,
+                                                 pred->stringValue));
+}
+
+//
+// predicate_mayMatchRange
+//
+bool predicate_mayMatchRange(struct Predicate *pred, double min, double max) {
+  if (pred->colType == COL_TYPE_STRING)
+    return true;
+
+  // ints are exact as doubles, so both types compare the same way
+  double value =
+      (pred->colType == COL_TYPE_INT) ? (double)pred->intValue : pred->realValue;
+
+  if (pred->colType == COL_TYPE_REAL && pred->operator == EXPR_EQUAL)
+    return (min - value) < 0.00001; // same test as predicate_matches
+
+  if (pred->operator == EXPR_LT) {
+    return min < value;
+  }
+  if (pred->operator == EXPR_LTE) {
+    return min <= value;
+  }
+  if (pred->operator == EXPR_GT) {
+    return max > value;
+  }
+  if (pred->operator == EXPR_GTE) {
+    return max >= value;
+  }
+  if (pred->operator == EXPR_EQUAL) {
+    return min <= value && value <= max;
+  }
+  if (pred->operator == EXPR_NOT_EQUAL) {
+    return !(min == value && max == value);
+  }
+  return true;
+}
@@ -0,0 +1,68 @@
+/*predicate.h*/
+
+//
+// Project: Where clause predicates for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+
+#include "ast.h"
+#include "database.h"
+#include "decoder.h"
+
+//
+// A Predicate is the where clause of a query, prepared once so it
+// can be evaluated against each decoded field during a scan: the
+// column is resolved to its position in the table, and the literal
+// is converted to the column's type up front.
+//
+struct Predicate
+{
+  int    column;      // index of the column in the table (0-based)
+  int    colType;     // enum ColumnType (database.h)
+  int    operator;    // enum AST_EXPR_OPERATORS (ast.h)
+
+  int    intValue;    // the literal, for COL_TYPE_INT
+  double realValue;   // the literal, for COL_TYPE_REAL
+  char*  stringValue; // the literal, for COL_TYPE_STRING
+};
+
+
+//
+// Functions:
+//
+
+//
+// predicate_init
+//
+// Prepares the given where clause expression for evaluation against
+// the records of the given table.
+//
+void predicate_init(struct Predicate* pred, struct TableMeta* tablemeta,
+  struct EXPR* expr);
+
+//
+// predicate_matches
+//
+// Returns true if the given field --- which must be the value of the
+// predicate's column --- satisfies the predicate. Strings are
+// compared case-insensitively, and may be matched against a LIKE
+// pattern, where % matches any sequence of chars and _ any one char.
+// Only strings can be LIKE a pattern.
+//
+bool predicate_matches(struct Predicate* pred, struct FieldValue* field);
+
+//
+// predicate_mayMatchRange
+//
+// Returns false if no value v with min <= v <= max can satisfy the
+// predicate, and true if some value might; strings always might.
+// Used to skip whole blocks of records using their zone map.
+//
+bool predicate_mayMatchRange(struct Predicate* pred, double min, double max);
@@ -0,0 +1,157 @@
+/*readahead.c*/
+
+//
+// Project: Read-ahead of table data for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#define _DEFAULT_SOURCE // madvise, MADV_WILLNEED under -std=c11
+
+#include <pthread.h> // pthread_create, pthread_join
+#include <stdbool.h> // true, false
+#include <stdint.h>  // uintptr_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h> // madvise
+#include <unistd.h>   // sysconf
+
+#include "readahead.h"
+#include "tablefile.h"
+#include "util.h"
+
+// reads chunk c of the range: the kernel is asked to start reading
+// all of it at once, then each page is touched so that it is resident
+// by the time the scan gets there
+static void readChunk(struct ReadAhead *ra, int c) {
+  struct TableFile *tf = ra->tablefile;
+  int firstRec = ra->first + (c * ra->chunkRecords);
+  int lastRec = firstRec + ra->chunkRecords;
+  if (lastRec > ra->last)
+    lastRec = ra->last;
+
+  size_t numBytes = 0;
+  const char *start = tablefile_records(tf, firstRec, lastRec, &numBytes);
+
+  // madvise requires a page-aligned address; the mapping itself is
+  long pageSize = sysconf(_SC_PAGESIZE);
+  if (pageSize <= 0)
+    pageSize = 4096;
+  uintptr_t offset = (uintptr_t)(start - tf->data) % (uintptr_t)pageSize;
+  madvise((void *)(start - offset), numBytes + offset, MADV_WILLNEED);
+
+  volatile char sink = 0;
+  for (size_t i = 0; i < numBytes; i += (size_t)pageSize) {
+    sink += start[i];
+  }
+  sink += start[numBytes - 1];
+  (void)sink;
+}
+
+// reader thread: reads chunks in order, staying at most READAHEAD_CHUNKS
+// chunks ahead of the chunk being decoded
+static void *readerThread(void *arg) {
+  struct ReadAhead *ra = (struct ReadAhead *)arg;
+
+  while (true) {
+    pthread_mutex_lock(&ra->lock);
+    while (!ra->stop && ra->nextChunk > ra->scanChunk + READAHEAD_CHUNKS)
+      pthread_cond_wait(&ra->advanced, &ra->lock);
+
+    if (ra->nextChunk <= ra->scanChunk) // the scan skipped ahead of us
+      ra->nextChunk = ra->scanChunk + 1;
+    int c = ra->nextChunk;
+    ra->nextChunk++;
+    bool stop = ra->stop;
+    pthread_mutex_unlock(&ra->lock);
+
+    if (stop || c >= ra->numChunks)
+      break;
+
+    readChunk(ra, c);
+  }
+
+  return NULL;
+}
+
+//
+// readahead_start
+//
+struct ReadAhead *readahead_start(struct TableFile *tablefile, int first,
+                                  int last) {
+  if (tablefile == NULL)
+    panic("tablefile is NULL (readahead_start)");
+
+  if (!tablefile->mapped) // already in memory
+    return NULL;
+
+  int chunkRecords = READAHEAD_CHUNK_BYTES / tablefile->stride;
+  if (chunkRecords < 1)
+    chunkRecords = 1;
+
+  int numChunks = (last - first + chunkRecords - 1) / chunkRecords;
+  if (numChunks <= READAHEAD_CHUNKS) // kernel read-ahead is enough
+    return NULL;
+
+  struct ReadAhead *ra = (struct ReadAhead *)malloc(sizeof(struct ReadAhead));
+  if (ra == NULL)
+    panic("out of memory");
+
+  ra->tablefile = tablefile;
+  ra->first = first;
+  ra->last = last;
+  ra->chunkRecords = chunkRecords;
+  ra->numChunks = numChunks;
+  ra->nextChunk = 1; // the scan faults in chunk 0 itself
+  ra->scanChunk = 0;
+  ra->stop = false;
+  pthread_mutex_init(&ra->lock, NULL);
+  pthread_cond_init(&ra->advanced, NULL);
+
+  if (pthread_create(&ra->reader, NULL, readerThread, ra) != 0) {
+    // no thread, no read-ahead; the scan works just the same
+    pthread_cond_destroy(&ra->advanced);
+    pthread_mutex_destroy(&ra->lock);
+    free(ra);
+    return NULL;
+  }
+
+  return ra;
+}
+
+//
+// readahead_advance
+//
+int readahead_advance(struct ReadAhead *ra, int recNum) {
+  int c = (recNum - ra->first) / ra->chunkRecords;
+
+  pthread_mutex_lock(&ra->lock);
+  if (c > ra->scanChunk) {
+    ra->scanChunk = c;
+    pthread_cond_signal(&ra->advanced);
+  }
+  pthread_mutex_unlock(&ra->lock);
+
+  return ra->first + ((c + 1) * ra->chunkRecords);
+}
+
+//
+// readahead_stop
+//
+void readahead_stop(struct ReadAhead *ra) {
+  if (ra == NULL)
+    return;
+
+  pthread_mutex_lock(&ra->lock);
+  ra->stop = true;
+  pthread_cond_signal(&ra->advanced);
+  pthread_mutex_unlock(&ra->lock);
+
+  pthread_join(ra->reader, NULL);
+
+  pthread_cond_destroy(&ra->advanced);
+  pthread_mutex_destroy(&ra->lock);
+  free(ra);
+}
@@ -0,0 +1,81 @@
+/*readahead.h*/
+
+//
+// Project: Read-ahead of table data for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <pthread.h> // pthread_t, pthread_mutex_t, pthread_cond_t
+#include <stdbool.h> // true, false
+
+#include "tablefile.h"
+
+//
+// A ReadAhead overlaps I/O with decoding while a range of records
+// is scanned out of a mapped .data file. The range is split into
+// chunks of about READAHEAD_CHUNK_BYTES; a dedicated reader thread
+// asks the kernel for chunk k+1 and faults its pages in while the
+// scanning thread decodes chunk k, staying at most READAHEAD_CHUNKS
+// chunks ahead --- in effect double buffering on top of the mapping.
+// On a cold page cache, the scanning thread then rarely waits for
+// the disk; on a warm one, the reader finds every page resident.
+//
+#define READAHEAD_CHUNK_BYTES (1024 * 1024)
+#define READAHEAD_CHUNKS      2
+
+struct ReadAhead
+{
+  struct TableFile* tablefile;
+  int               first;         // the range of records [first, last)
+  int               last;
+  int               chunkRecords;  // # of records per chunk
+  int               numChunks;
+
+  int               nextChunk;     // next chunk to read, guarded by lock
+  int               scanChunk;     // chunk being decoded, guarded by lock
+  bool              stop;          // guarded by lock
+  pthread_mutex_t   lock;
+  pthread_cond_t    advanced;      // signaled when scanChunk or stop changes
+  pthread_t         reader;
+};
+
+
+//
+// Functions:
+//
+
+//
+// readahead_start
+//
+// Starts reading ahead records [first, last) of the given table file,
+// in order. Returns NULL if read-ahead would not help, i.e. the file
+// is not mapped (then it was read into memory when opened) or the
+// range is only a chunk or two.
+//
+// NOTE: it is the caller's responsibility to stop the reader thread
+// by calling readahead_stop().
+//
+struct ReadAhead* readahead_start(struct TableFile* tablefile, int first,
+  int last);
+
+//
+// readahead_advance
+//
+// Tells the reader thread that the scan has reached record recNum,
+// so it may read further ahead. Returns the next record # at which
+// to call this again; records may be skipped in between.
+//
+int readahead_advance(struct ReadAhead* ra, int recNum);
+
+//
+// readahead_stop
+//
+// Stops the reader thread, whether or not the scan reached the end
+// of the range, and frees the memory associated with the read-ahead.
+//
+void readahead_stop(struct ReadAhead* ra);
@@ -0,0 +1,146 @@
+/*rsutil.c*/
+
+//
+// Project: Result Set extensions for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <ctype.h> // tolower
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h> // strcasecmp
+
+#include "resultset.h"
+#include "rsutil.h"
+#include "util.h"
+
+//
+// rsutil_truncateRows
+//
+void rsutil_truncateRows(struct ResultSet *rs, int numRows) {
+  if (rs == NULL)
+    panic("rs is NULL (rsutil_truncateRows)");
+  if (numRows < 0)
+    panic("numRows is negative (rsutil_truncateRows)");
+
+  if (numRows >= rs->numRows)
+    return;
+
+  for (struct RSColumn *col = rs->columns; col != NULL; col = col->next) {
+    // the rows deleted own their strings, so those are freed
+    for (int i = numRows; i < col->N; i++) {
+      if (col->data[i].valueType == COL_TYPE_STRING)
+        free(col->data[i].value.s);
+    }
+    col->N = numRows;
+  }
+
+  rs->numRows = numRows;
+}
+
+// returns the hash of the string, ignoring case
+static unsigned int hashFolded(const char *s) {
+  unsigned int hash = 2166136261u; // FNV-1a
+  for (; *s != '\0'; s++) {
+    hash ^= (unsigned char)tolower((unsigned char)*s);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+//
+// rsutil_findColumns
+//
+void rsutil_findColumns(struct ResultSet *rs, char **names, int numNames,
+                        int *positions) {
+  if (rs == NULL)
+    panic("rs is NULL (rsutil_findColumns)");
+
+  //
+  // an open-addressing table at most half full, mapping the columns'
+  // case-folded names to their positions; with duplicate names, the
+  // first column wins, like resultset_findColumn:
+  //
+  int numSlots = 1;
+  while (numSlots < 2 * rs->numCols) {
+    numSlots *= 2;
+  }
+
+  struct RSColumn **slots =
+      (struct RSColumn **)calloc(numSlots, sizeof(struct RSColumn *));
+  int *slotPositions = (int *)malloc(sizeof(int) * numSlots);
+  if (slots == NULL || slotPositions == NULL)
+    panic("out of memory");
+
+  int position = 1;
+  for (struct RSColumn *col = rs->columns; col != NULL; col = col->next) {
+    unsigned int s = hashFolded(col->colName) & (numSlots - 1);
+    while (slots[s] != NULL && strcasecmp(slots[s]->colName, col->colName) != 0)
+      s = (s + 1) & (numSlots - 1);
+    if (slots[s] == NULL) {
+      slots[s] = col;
+      slotPositions[s] = position;
+    }
+    position++;
+  }
+
+  for (int n = 0; n < numNames; n++) {
+    positions[n] = -1;
+
+    unsigned int s = hashFolded(names[n]) & (numSlots - 1);
+    while (slots[s] != NULL) {
+      if (strcasecmp(slots[s]->colName, names[n]) == 0) {
+        positions[n] = slotPositions[s];
+        break;
+      }
+      s = (s + 1) & (numSlots - 1);
+    }
+  }
+
+  free(slotPositions);
+  free(slots);
+}
+
+//
+// rsutil_permuteColumns
+//
+void rsutil_permuteColumns(struct ResultSet *rs, const int *order) {
+  if (rs == NULL)
+    panic("rs is NULL (rsutil_permuteColumns)");
+  if (rs->numCols == 0)
+    return;
+
+  struct RSColumn **columns =
+      (struct RSColumn **)malloc(sizeof(struct RSColumn *) * rs->numCols);
+  if (columns == NULL)
+    panic("out of memory");
+
+  int c = 0;
+  for (struct RSColumn *col = rs->columns; col != NULL; col = col->next) {
+    columns[c] = col;
+    c++;
+  }
+
+  // each column is taken out of the array as it is linked, so one
+  // that comes up twice is caught
+  struct RSColumn *prev = NULL;
+  for (int i = 0; i < rs->numCols; i++) {
+    if (order[i] < 1 || order[i] > rs->numCols ||
+        columns[order[i] - 1] == NULL)
+      panic("order is not a permutation (rsutil_permuteColumns)");
+
+    struct RSColumn *col = columns[order[i] - 1];
+    columns[order[i] - 1] = NULL;
+    if (prev == NULL)
+      rs->columns = col;
+    else
+      prev->next = col;
+    prev = col;
+  }
+  prev->next = NULL;
+
+  free(columns);
+}
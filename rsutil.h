@@ -0,0 +1,59 @@
+/*rsutil.h*/
+
+//
+// Project: Result Set extensions for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include "resultset.h"
+
+//
+// Operations on result sets that the resultset_* functions don't
+// provide. These work directly on the data structure described in
+// resultset.h (a linked-list of columns, each storing its values in
+// a dynamically-allocated array), so they can work on a whole column
+// or row range at once rather than one value at a time.
+//
+
+
+//
+// Functions:
+//
+
+//
+// rsutil_truncateRows
+//
+// Deletes every row after the first numRows rows, in one pass over
+// each column; does nothing if the result set has numRows rows or
+// fewer. Same as calling resultset_deleteRow() on the last row until
+// only numRows are left, without shifting any values.
+//
+void rsutil_truncateRows(struct ResultSet* rs, int numRows);
+
+//
+// rsutil_findColumns
+//
+// For each name in names[0..numNames-1], stores in positions[] the
+// position (1-based) of the result set's column with that name ---
+// case-insensitive, and ignoring table names --- or -1 if there is
+// none. The columns are hashed by their case-folded names, so this
+// takes time proportional to numCols + numNames, rather than one
+// walk of the columns per name as with resultset_findColumn().
+//
+void rsutil_findColumns(struct ResultSet* rs, char** names, int numNames,
+  int* positions);
+
+//
+// rsutil_permuteColumns
+//
+// Reorders the columns of the result set so that the column at
+// position i (1-based) is the one that was at position order[i-1];
+// order must be a permutation of 1..numCols. The columns are relinked
+// in a single pass, and no values are moved.
+//
+void rsutil_permuteColumns(struct ResultSet* rs, const int* order);
@@ -0,0 +1,898 @@
+/*scan.c*/
+
+//
+// Project: Table scans for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <limits.h>  // INT_MAX
+#include <pthread.h> // pthread_create, pthread_join
+#include <stdbool.h> // true, false
+#include <stdint.h>  // uint32_t, uint64_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memcpy
+
+#include "ast.h"
+#include "bitmap.h"
+#include "btree.h"
+#include "colcache.h"
+#include "colvec.h"
+#include "database.h"
+#include "decoder.h"
+#include "directmap.h"
+#include "hashidx.h"
+#include "indexer.h"
+#include "learned.h"
+#include "options.h"
+#include "permutation.h"
+#include "predicate.h"
+#include "readahead.h"
+#include "scan.h"
+#include "tablefile.h"
+#include "trigram.h"
+#include "util.h"
+#include "zonemap.h"
+
+//
+// Where the records of a table come from: a valid columnar cache if
+// there is one, otherwise the mapped .data file and a decoder. Both
+// are read-only once opened, so worker threads share one source.
+// When the where clause is on a numeric column, the table's zone map
+// (if any) tells which blocks of records can be skipped. When a
+// covering index holds every needed column, the rows are read from
+// the index's entries instead, and the records are not read at all.
+//
+struct TableSource
+{
+  struct TableMeta*     tablemeta;
+  bool*                 needed;    // ARRAY: columns to decode
+  struct ColumnCache*   cache;     // NULL => decode the .data file
+  struct TableFile*     tablefile;
+  struct RecordDecoder* decoder;
+  bool*                 filterNeeded;  // ARRAY: only the where column
+  struct RecordDecoder* filterDecoder; // decodes only the where column
+  struct ZoneMap*       zonemap;   // NULL => no blocks are skipped
+  struct BTree*         covering;  // NULL => read the records
+  int                   numRecords;
+};
+
+//
+// One contiguous range of records [first, last), and the partial
+// results it produced. When an index picked out the records, the
+// range is of positions in the ScanWork's list of record #s instead.
+//
+struct Partition
+{
+  int                   first;
+  int                   last;
+  struct ColumnVectors* vectors;
+};
+
+//
+// The work shared by the worker threads: each worker repeatedly
+// claims the next unscanned partition until there are none left,
+// or until a limit on the # of rows has been met.
+//
+struct ScanWork
+{
+  struct TableSource* source;
+  struct Predicate*   where;         // NULL => no where clause
+  int*                rows;          // NULL => all records, in order
+  int                 limit;         // -1 => no limit
+  struct Partition*   partitions;
+  int                 numPartitions;
+  int                 nextPartition; // guarded by lock, as are the rest
+  int                 numFinished;   // # of leading partitions finished
+  int                 rowsFinished;  // # of rows in those partitions
+  bool                stop;          // true => enough rows for the limit
+  pthread_mutex_t     lock;
+};
+
+// opens the table's data: if enabled, a valid columnar cache
+// ("TABLE-NAME.col") is read instead of the .data file, and when
+// there is none yet, it is built from the .data file first (unless
+// buildCache is false, since building reads the entire file). The
+// zone map ("TABLE-NAME.zmap") is opened, or built, the same way if
+// the where clause can use it. Records are filtered on the where
+// column alone, so a second decoder skips all the others
+static void openSource(struct TableSource *source, struct Database *db,
+                       struct TableMeta *tablemeta, bool *needed,
+                       struct Predicate *where, bool buildCache) {
+  struct Options *options = options_get();
+
+  source->tablemeta = tablemeta;
+  source->needed = needed;
+  source->cache = NULL;
+  source->tablefile = NULL;
+  source->decoder = NULL;
+  source->filterNeeded = NULL;
+  source->filterDecoder = NULL;
+  source->zonemap = NULL;
+  source->covering = NULL;
+
+  if (where != NULL) {
+    source->filterNeeded = (bool *)malloc(sizeof(bool) * tablemeta->numColumns);
+    if (source->filterNeeded == NULL)
+      panic("out of memory");
+    for (int i = 0; i < tablemeta->numColumns; i++) {
+      source->filterNeeded[i] = (i == where->column);
+    }
+  }
+
+  if (options->useColumnCache)
+    source->cache = colcache_open(db, tablemeta);
+
+  if (source->cache == NULL) {
+    //
+    // the table exists within a sub-directory under the executable
+    // where the directory has the same name as the database, and with
+    // a "TABLE-NAME.data" filename within that sub-directory:
+    //
+    source->tablefile = tablefile_open(db, tablemeta);
+    if (source->tablefile == NULL) // unable to open:
+    {
+      printf("**INTERNAL ERROR: table's data file '%s/%s.data' not found.\n",
+             db->name, tablemeta->name);
+      panic("execution halted");
+      exit(-1);
+    }
+
+    if (options->useColumnCache && buildCache)
+      source->cache = colcache_build(db, tablemeta, source->tablefile);
+  }
+
+  if (options->useZoneMaps && where != NULL &&
+      where->colType != COL_TYPE_STRING) {
+    source->zonemap = zonemap_open(db, tablemeta);
+    if (source->zonemap == NULL && buildCache)
+      source->zonemap =
+          zonemap_build(db, tablemeta, source->cache, source->tablefile);
+  }
+
+  if (source->cache != NULL) { // the .data file is no longer needed
+    tablefile_close(source->tablefile);
+    source->tablefile = NULL;
+    source->numRecords = source->cache->numRows;
+  } else {
+    source->decoder = decoder_create(tablemeta, needed);
+    if (where != NULL)
+      source->filterDecoder = decoder_create(tablemeta, source->filterNeeded);
+    source->numRecords = source->tablefile->numRecords;
+  }
+}
+
+// releases everything opened by openSource
+static void closeSource(struct TableSource *source) {
+  btree_close(source->covering);
+  zonemap_close(source->zonemap);
+  decoder_destroy(source->filterDecoder);
+  free(source->filterNeeded);
+  decoder_destroy(source->decoder);
+  colcache_close(source->cache);
+  tablefile_close(source->tablefile);
+}
+
+// decodes the given fields of record (or covering index entry) r into
+// values, from wherever the source keeps them
+static void decodeRecord(struct TableSource *source, int r, bool indexed,
+                         bool *needed, struct RecordDecoder *decoder,
+                         struct FieldValue *values) {
+  if (source->covering != NULL && indexed)
+    btree_decode(source->covering, r, needed, values);
+  else if (source->cache != NULL)
+    colcache_decode(source->cache, r, needed, values);
+  else
+    decoder_decode(decoder, tablefile_record(source->tablefile, r), values);
+}
+
+// decodes records [first, last) into new column vectors, keeping only
+// the rows that satisfy the where clause (if any); stops early once
+// they have limit rows, unless limit is -1. If rows is not NULL,
+// the records decoded are rows[first..last-1] instead; with a covering
+// index, these are the #s of its entries rather than of records
+static struct ColumnVectors *scanPartition(struct TableSource *source,
+                                           struct Predicate *where, int *rows,
+                                           int first, int last, int limit) {
+  struct TableMeta *tablemeta = source->tablemeta;
+  bool *needed = source->needed;
+  struct ColumnVectors *vectors = colvec_create(tablemeta, needed);
+
+  //
+  // the records are processed in batches of up to SCAN_BATCH_RECORDS.
+  // First, only the where column of each record in the batch is
+  // decoded and tested, and the #s of the records that satisfy the
+  // where clause are collected in a selection vector; blocks of
+  // records the zone map rules out are never decoded at all. Then,
+  // only the selected records have their needed fields decoded and
+  // appended to the column vectors' typed arrays, either from the
+  // cache's typed arrays or straight out of the mapped .data file:
+  //
+  struct FieldValue *values = (struct FieldValue *)malloc(
+      sizeof(struct FieldValue) * tablemeta->numColumns);
+  int *selection = (int *)malloc(sizeof(int) * SCAN_BATCH_RECORDS);
+  if (values == NULL || selection == NULL)
+    panic("out of memory");
+
+  struct ZoneMap *zonemap =
+      (where != NULL && rows == NULL) ? source->zonemap : NULL;
+
+  // when decoding the .data file, a reader thread keeps the next chunk
+  // of records coming in from disk while this one is decoded
+  struct ReadAhead *ra = NULL;
+  int nextAdvance = last;
+  if (source->tablefile != NULL && source->cache == NULL && rows == NULL &&
+      options_get()->useReadAhead)
+    ra = readahead_start(source->tablefile, first, last);
+  if (ra != NULL)
+    nextAdvance = first;
+
+  int pos = first;
+  while (pos < last && vectors->numRows != limit) {
+    //
+    // (1) select the records of the next batch:
+    //
+    int batchEnd = (last - pos > SCAN_BATCH_RECORDS) ? pos + SCAN_BATCH_RECORDS
+                                                      : last;
+    int batchStart = pos;
+    int numSelected = 0;
+
+    for (; pos < batchEnd; pos++) {
+      int r = (rows != NULL) ? rows[pos] : pos;
+
+      if (zonemap != NULL &&
+          (pos == batchStart || r % ZONEMAP_BLOCK_RECORDS == 0) &&
+          !zonemap_mayMatch(zonemap, where, r / ZONEMAP_BLOCK_RECORDS)) {
+        int blockEnd = (r / ZONEMAP_BLOCK_RECORDS + 1) * ZONEMAP_BLOCK_RECORDS;
+        pos = ((blockEnd < batchEnd) ? blockEnd : batchEnd) - 1; // skips it
+        continue;
+      }
+
+      if (pos >= nextAdvance)
+        nextAdvance = readahead_advance(ra, pos);
+
+      if (where != NULL) {
+        decodeRecord(source, r, rows != NULL, source->filterNeeded,
+                     source->filterDecoder, values);
+        if (!predicate_matches(where, &values[where->column]))
+          continue;
+      }
+
+      selection[numSelected] = r;
+      numSelected++;
+    }
+
+    //
+    // (2) add the needed fields of the selected records:
+    //
+    for (int s = 0; s < numSelected && vectors->numRows != limit; s++) {
+      decodeRecord(source, selection[s], rows != NULL, needed, source->decoder,
+                   values);
+      colvec_addRow(vectors, values);
+    }
+  }
+  readahead_stop(ra);
+  free(selection);
+  free(values);
+
+  return vectors;
+}
+
+// worker thread: scans partitions in order until there are none left, or
+// until the partitions scanned so far hold enough rows for the limit
+static void *scanWorker(void *arg) {
+  struct ScanWork *work = (struct ScanWork *)arg;
+
+  while (true) {
+    pthread_mutex_lock(&work->lock);
+    int p = work->nextPartition;
+    work->nextPartition++;
+    bool stop = work->stop;
+    pthread_mutex_unlock(&work->lock);
+
+    if (stop || p >= work->numPartitions)
+      break;
+
+    struct Partition *partition = &work->partitions[p];
+    struct ColumnVectors *vectors =
+        scanPartition(work->source, work->where, work->rows, partition->first,
+                      partition->last, work->limit);
+
+    pthread_mutex_lock(&work->lock);
+    partition->vectors = vectors;
+
+    // partitions are claimed in order, so once the leading run of
+    // finished partitions holds enough rows, the rest are not needed
+    while (work->numFinished < work->numPartitions &&
+           work->partitions[work->numFinished].vectors != NULL) {
+      work->rowsFinished +=
+          work->partitions[work->numFinished].vectors->numRows;
+      work->numFinished++;
+    }
+    if (work->limit >= 0 && work->rowsFinished >= work->limit)
+      work->stop = true;
+    pthread_mutex_unlock(&work->lock);
+  }
+
+  return NULL;
+}
+
+// orders record #s ascending
+static int compareRecNums(const void *a, const void *b) {
+  int r1 = *(const int *)a;
+  int r2 = *(const int *)b;
+  return (r1 < r2) ? -1 : (r1 > r2);
+}
+
+// orders (record #, entry #) pairs, packed into one uint64_t each
+static int comparePairs(const void *a, const void *b) {
+  uint64_t p1 = *(const uint64_t *)a;
+  uint64_t p2 = *(const uint64_t *)b;
+  return (p1 < p2) ? -1 : (p1 > p2);
+}
+
+// allocates an array for n record #s
+static int *allocRows(int n) {
+  int *rows = (int *)malloc(sizeof(int) * n + 1); // +1 so 0 rows isn't NULL
+  if (rows == NULL)
+    panic("out of memory");
+  return rows;
+}
+
+// looks up key = value on an indexed int column with dense keys in
+// the column's direct-address map: the matches are at a slot of it
+static bool findDirectRows(struct Database *db, struct TableSource *source,
+                           struct Predicate *where, bool buildIndex,
+                           int maxRows, int **rows, int *numRows) {
+  if (!options_get()->useDirectMaps)
+    return false;
+
+  struct TableMeta *tablemeta = source->tablemeta;
+  struct DirectMap *dmap = directmap_open(db, tablemeta, where->column);
+  if (dmap == NULL && buildIndex)
+    dmap = directmap_build(db, tablemeta, where->column, source->cache,
+                           source->tablefile);
+  if (dmap == NULL)
+    return false;
+
+  bool found = false;
+  if (dmap->dense) {
+    int first = 0;
+    int last = 0;
+    directmap_find(dmap, where->intValue, &first, &last);
+
+    found = (last - first <= maxRows);
+    if (found) {
+      *numRows = last - first;
+      if (rows != NULL) { // already in record order
+        *rows = allocRows(last - first);
+        memcpy(*rows, dmap->recNums + first, sizeof(int32_t) * (last - first));
+      }
+    }
+  }
+
+  directmap_close(dmap);
+  return found;
+}
+
+// looks up key = value on a unique-indexed int column in the column's
+// hash index: one probe finds the only record that can match
+static bool findUniqueRow(struct Database *db, struct TableSource *source,
+                          struct Predicate *where, bool buildIndex, int **rows,
+                          int *numRows) {
+  struct TableMeta *tablemeta = source->tablemeta;
+  struct HashIndex *hashidx = hashidx_open(db, tablemeta, where->column);
+  if (hashidx == NULL && buildIndex)
+    hashidx = hashidx_build(db, tablemeta, where->column, source->cache,
+                            source->tablefile);
+  if (hashidx == NULL)
+    return false;
+  if (!hashidx->unique) { // a key repeats, so use the B+tree
+    hashidx_close(hashidx);
+    return false;
+  }
+
+  int recNum = hashidx_find(hashidx, where->intValue);
+  *numRows = (recNum >= 0) ? 1 : 0;
+  if (rows != NULL) {
+    *rows = allocRows(1);
+    (*rows)[0] = recNum;
+  }
+
+  hashidx_close(hashidx);
+  return true;
+}
+
+// returns the # of the first entry of the B+tree whose key is >= key
+// (or > key, if upper is true), predicted by the learned index if
+// there is one, otherwise found by a search down the tree
+static int findBound(struct BTree *btree, struct LearnedIndex *learned,
+                     int key, bool upper) {
+  if (learned != NULL)
+    return upper ? learned_upperBound(learned, btree, key)
+                 : learned_lowerBound(learned, btree, key);
+
+  return upper ? btree_upperBound(btree, key) : btree_lowerBound(btree, key);
+}
+
+// finds the range of entries [*first, *last) of the B+tree whose keys
+// satisfy the where clause, or all of them if there is none; the
+// entries are in key order, so the matches are a range of them. The
+// column's learned index, if enabled, finds the bounds (it is built
+// first if there is none, and buildIndex is true)
+static void findBTreeRange(struct Database *db, struct TableMeta *tablemeta,
+                           struct BTree *btree, struct Predicate *where,
+                           bool buildIndex, int *first, int *last) {
+  *first = 0;
+  *last = btree->numEntries;
+  if (where == NULL)
+    return;
+
+  struct LearnedIndex *learned = NULL;
+  if (options_get()->useLearnedIndexes) {
+    learned = learned_open(db, tablemeta, btree->column);
+    if (learned == NULL && buildIndex)
+      learned = learned_build(db, tablemeta, btree);
+    if (learned != NULL && !learned->fitted) { // the B+tree is searched
+      learned_close(learned);
+      learned = NULL;
+    }
+  }
+
+  int key = where->intValue;
+  if (where->operator == EXPR_EQUAL) {
+    *first = findBound(btree, learned, key, false);
+    *last = findBound(btree, learned, key, true);
+  } else if (where->operator == EXPR_LT) {
+    *last = findBound(btree, learned, key, false);
+  } else if (where->operator == EXPR_LTE) {
+    *last = findBound(btree, learned, key, true);
+  } else if (where->operator == EXPR_GT) {
+    *first = findBound(btree, learned, key, true);
+  } else if (where->operator == EXPR_GTE) {
+    *first = findBound(btree, learned, key, false);
+  }
+
+  learned_close(learned);
+}
+
+// looks up a comparison on an indexed int column in the column's
+// B+tree index: the matches are a range of its entries. If the index
+// covers the needed columns, it becomes the source's covering index,
+// and rows are the #s of those entries, ordered by their records
+static bool findBTreeRows(struct Database *db, struct TableSource *source,
+                          struct Predicate *where, bool buildIndex,
+                          int maxRows, int **rows, int *numRows) {
+  struct TableMeta *tablemeta = source->tablemeta;
+  struct BTree *btree = btree_open(db, tablemeta, where->column);
+  if (btree == NULL && buildIndex)
+    btree = btree_build(db, tablemeta, where->column, source->cache,
+                        source->tablefile);
+  if (btree == NULL)
+    return false;
+
+  int first = 0;
+  int last = 0;
+  findBTreeRange(db, tablemeta, btree, where, buildIndex, &first, &last);
+
+  bool found = (last - first <= maxRows);
+  if (found) {
+    *numRows = last - first;
+    if (rows != NULL) { // rows come out in record order, just like a scan
+      *rows = allocRows(last - first);
+      btree_recNums(btree, first, last, *rows);
+
+      if (btree_covers(btree, source->needed, tablemeta->numColumns)) {
+        uint64_t *pairs =
+            (uint64_t *)malloc(sizeof(uint64_t) * (last - first) + 1);
+        if (pairs == NULL)
+          panic("out of memory");
+
+        for (int e = first; e < last; e++) {
+          pairs[e - first] =
+              ((uint64_t)(uint32_t)(*rows)[e - first] << 32) | (uint32_t)e;
+        }
+        qsort(pairs, last - first, sizeof(uint64_t), comparePairs);
+        for (int i = 0; i < last - first; i++) {
+          (*rows)[i] = (int)(uint32_t)pairs[i];
+        }
+        free(pairs);
+
+        source->covering = btree; // closed with the source
+        btree = NULL;
+      } else {
+        qsort(*rows, last - first, sizeof(int), compareRecNums);
+      }
+    }
+  }
+
+  btree_close(btree);
+  return found;
+}
+
+// finds the range of entries [*first, *last) of the permutation whose
+// values satisfy the where clause; the values are sorted, so the
+// matches are a range of them, even for = on a real column, which
+// matches every value less than 0.00001 above the literal
+static void findSortedRange(struct Permutation *perm, struct Predicate *where,
+                            int *first, int *last) {
+  *first = 0;
+  *last = perm->numEntries;
+
+  double key = (where->colType == COL_TYPE_INT) ? (double)where->intValue
+                                                : where->realValue;
+  if (where->operator == EXPR_EQUAL && where->colType == COL_TYPE_REAL) {
+    // same test as predicate_matches, where the bound is off by rounding
+    *last = permutation_lowerBound(perm, key + 0.00001);
+    while (*last < perm->numEntries && perm->values[*last] - key < 0.00001)
+      (*last)++;
+    while (*last > 0 && !(perm->values[*last - 1] - key < 0.00001))
+      (*last)--;
+  } else if (where->operator == EXPR_EQUAL) {
+    *first = permutation_lowerBound(perm, key);
+    *last = permutation_upperBound(perm, key);
+  } else if (where->operator == EXPR_LT) {
+    *last = permutation_lowerBound(perm, key);
+  } else if (where->operator == EXPR_LTE) {
+    *last = permutation_upperBound(perm, key);
+  } else if (where->operator == EXPR_GT) {
+    *first = permutation_upperBound(perm, key);
+  } else if (where->operator == EXPR_GTE) {
+    *first = permutation_lowerBound(perm, key);
+  }
+}
+
+// looks up a comparison on a non-indexed int or real column in the
+// column's sorted permutation: the matches are a range of its entries
+static bool findSortedRows(struct Database *db, struct TableSource *source,
+                           struct Predicate *where, bool buildIndex,
+                           int maxRows, int **rows, int *numRows) {
+  if (!options_get()->usePermutations)
+    return false;
+
+  struct TableMeta *tablemeta = source->tablemeta;
+  struct Permutation *perm = permutation_open(db, tablemeta, where->column);
+  if (perm == NULL && buildIndex)
+    perm = permutation_build(db, tablemeta, where->column, source->cache,
+                             source->tablefile);
+  if (perm == NULL)
+    return false;
+
+  int first = 0;
+  int last = 0;
+  findSortedRange(perm, where, &first, &last);
+
+  bool found = (last - first <= maxRows);
+  if (found) {
+    *numRows = last - first;
+    if (rows != NULL) { // rows come out in record order, just like a scan
+      *rows = allocRows(last - first);
+      for (int e = first; e < last; e++) {
+        (*rows)[e - first] = perm->recNums[e];
+      }
+      qsort(*rows, last - first, sizeof(int), compareRecNums);
+    }
+  }
+
+  permutation_close(perm);
+  return found;
+}
+
+// looks up string = value in the column's bitmap index, if the column
+// has few enough distinct values to have one
+static bool findBitmapRows(struct Database *db, struct TableSource *source,
+                           struct Predicate *where, bool buildIndex,
+                           int maxRows, int **rows, int *numRows) {
+  struct TableMeta *tablemeta = source->tablemeta;
+  struct BitmapIndex *bitmap = bitmap_open(db, tablemeta, where->column);
+  if (bitmap == NULL && buildIndex)
+    bitmap = bitmap_build(db, tablemeta, where->column, source->cache,
+                          source->tablefile);
+  if (bitmap == NULL)
+    return false;
+
+  bool found = false;
+  if (bitmap->lowCardinality) {
+    int v = bitmap_find(bitmap, where->stringValue);
+    int count = (v >= 0) ? bitmap_count(bitmap, v) : 0;
+
+    found = (count <= maxRows);
+    if (found) {
+      *numRows = count;
+      if (rows != NULL) { // already in record order
+        *rows = allocRows(count);
+        if (v >= 0)
+          bitmap_recNums(bitmap, v, *rows);
+      }
+    }
+  }
+
+  bitmap_close(bitmap);
+  return found;
+}
+
+// looks up string LIKE pattern in the column's trigram index, which
+// narrows the records down to the candidates that contain every
+// trigram of the pattern; they must still be checked against it
+static bool findTrigramRows(struct Database *db, struct TableSource *source,
+                            struct Predicate *where, bool buildIndex,
+                            int maxRows, int **rows, int *numRows) {
+  struct TableMeta *tablemeta = source->tablemeta;
+  struct TrigramIndex *trigram = trigram_open(db, tablemeta, where->column);
+  if (trigram == NULL && buildIndex)
+    trigram = trigram_build(db, tablemeta, where->column, source->cache,
+                            source->tablefile);
+  if (trigram == NULL)
+    return false;
+
+  int count = 0;
+  int *candidates = trigram_candidates(trigram, where->stringValue, &count);
+  trigram_close(trigram);
+
+  if (candidates == NULL || count > maxRows) { // doesn't narrow it enough
+    free(candidates);
+    return false;
+  }
+
+  *numRows = count;
+  *rows = candidates;
+  return true;
+}
+
+// if an index can answer the where clause, looks up the records that
+// satisfy it: equality on an indexed int column with dense keys uses
+// the column's direct-address map, equality on other unique int
+// columns their hash index, other comparisons on an indexed int
+// column its B+tree, comparisons on other int and real columns their
+// sorted permutation, equality on a string column its bitmap index,
+// and LIKE its trigram index (an index is built first if there is
+// none and buildIndex is true, unless the indexer is building it in
+// the background). Returns their # via numRows, and if rows is not
+// NULL, their record #s in record order via rows; the trigram index
+// only finds candidates, so it can't be used to count. Returns false
+// if there is no usable index, or if more than maxRows records match
+static bool lookupIndex(struct Database *db, struct TableSource *source,
+                        struct Predicate *where, bool buildIndex, int maxRows,
+                        int **rows, int *numRows) {
+  if (where == NULL || !options_get()->useIndexes)
+    return false;
+
+  int indexType = source->tablemeta->columns[where->column].indexType;
+  if (buildIndex && indexer_pending(source->tablemeta, where->column))
+    buildIndex = false; // scan until the indexer is done with it
+
+  if (where->colType == COL_TYPE_STRING) {
+    if (where->operator == EXPR_EQUAL)
+      return findBitmapRows(db, source, where, buildIndex, maxRows, rows,
+                            numRows);
+    if (where->operator == EXPR_LIKE && rows != NULL) // candidates, not a count
+      return findTrigramRows(db, source, where, buildIndex, maxRows, rows,
+                             numRows);
+    return false;
+  }
+
+  if (where->operator == EXPR_NOT_EQUAL || where->operator == EXPR_LIKE)
+    return false;
+
+  if (where->colType != COL_TYPE_INT || indexType == COL_NON_INDEXED)
+    return findSortedRows(db, source, where, buildIndex, maxRows, rows,
+                          numRows);
+
+  if (where->operator == EXPR_EQUAL &&
+      findDirectRows(db, source, where, buildIndex, maxRows, rows, numRows))
+    return true;
+
+  if (where->operator == EXPR_EQUAL && indexType == COL_UNIQUE_INDEXED &&
+      findUniqueRow(db, source, where, buildIndex, rows, numRows))
+    return true;
+
+  return findBTreeRows(db, source, where, buildIndex, maxRows, rows, numRows);
+}
+
+//
+// scan_vectors
+//
+struct ColumnVectors *scan_vectors(struct Database *db, struct ScanPlan *plan) {
+  if (db == NULL)
+    panic("db is NULL (scan_vectors)");
+  if (plan == NULL)
+    panic("plan is NULL (scan_vectors)");
+
+  struct Predicate predicate;
+  struct Predicate *where = NULL;
+  if (plan->where != NULL) {
+    predicate_init(&predicate, plan->tablemeta, plan->where->expr);
+    where = &predicate;
+  }
+
+  struct TableSource source;
+  openSource(&source, db, plan->tablemeta, plan->columns, where,
+             plan->limit < 0); // a limited scan doesn't build the cache
+
+  //
+  // (1) without a where clause, the first N records are the answer to
+  // a limit of N, so there is no need to look at any others. With a
+  // selective where clause on an indexed column, only the records
+  // the index finds are looked at:
+  //
+  int numRecords = source.numRecords;
+  if (plan->limit >= 0 && where == NULL && plan->limit < numRecords)
+    numRecords = plan->limit;
+
+  int *rows = NULL;
+  lookupIndex(db, &source, where, plan->limit < 0,
+              source.numRecords / SCAN_INDEX_MAX_FRACTION, &rows, &numRecords);
+
+  //
+  // (2) split the records into partitions: several per thread so that
+  // threads which finish early can pick up more work, but never so
+  // small that a thread isn't worth it. With a where clause and a
+  // limit, we can't know how many records are needed, so the table is
+  // scanned in order in small partitions until there are enough rows:
+  //
+  int numThreads = options_get()->numThreads;
+  int numPartitions = 1;
+  if (plan->limit >= 0 && where != NULL) {
+    numPartitions = (numRecords + SCAN_MIN_PARTITION_RECORDS - 1) /
+                    SCAN_MIN_PARTITION_RECORDS;
+  } else if (numThreads > 1) {
+    numPartitions = numThreads * SCAN_PARTITIONS_PER_THREAD;
+    if (numPartitions > numRecords / SCAN_MIN_PARTITION_RECORDS)
+      numPartitions = numRecords / SCAN_MIN_PARTITION_RECORDS;
+  }
+  if (numPartitions < 1)
+    numPartitions = 1;
+  if (numThreads > numPartitions)
+    numThreads = numPartitions;
+
+  struct ScanWork work;
+  work.source = &source;
+  work.where = where;
+  work.rows = rows;
+  work.limit = plan->limit;
+  work.numPartitions = numPartitions;
+  work.nextPartition = 0;
+  work.numFinished = 0;
+  work.rowsFinished = 0;
+  work.stop = false;
+  work.partitions =
+      (struct Partition *)malloc(sizeof(struct Partition) * numPartitions);
+  pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * numThreads);
+  if (work.partitions == NULL || threads == NULL)
+    panic("out of memory");
+  pthread_mutex_init(&work.lock, NULL);
+
+  for (int p = 0; p < numPartitions; p++) { // record boundaries, evenly
+    work.partitions[p].first = (int)((long long)numRecords * p / numPartitions);
+    work.partitions[p].last =
+        (int)((long long)numRecords * (p + 1) / numPartitions);
+    work.partitions[p].vectors = NULL;
+  }
+
+  //
+  // (3) scan the partitions on the worker threads, or right here if a
+  // single thread will do:
+  //
+  if (numThreads <= 1) {
+    scanWorker(&work);
+  } else {
+    for (int t = 0; t < numThreads; t++) {
+      if (pthread_create(&threads[t], NULL, scanWorker, &work) != 0)
+        panic("unable to create scan thread (scan_vectors)");
+    }
+    for (int t = 0; t < numThreads; t++) {
+      pthread_join(threads[t], NULL);
+    }
+  }
+
+  //
+  // (4) merge the partial results in record order; if the scan stopped
+  // early, the scanned partitions are a leading run of them:
+  //
+  struct ColumnVectors *vectors = work.partitions[0].vectors;
+  for (int p = 1; p < numPartitions && work.partitions[p].vectors != NULL;
+       p++) {
+    colvec_appendRows(vectors, work.partitions[p].vectors);
+    colvec_destroy(work.partitions[p].vectors);
+  }
+
+  pthread_mutex_destroy(&work.lock);
+  free(threads);
+  free(work.partitions);
+  free(rows);
+  closeSource(&source);
+
+  return vectors;
+}
+
+//
+// scan_count
+//
+int scan_count(struct Database *db, struct ScanPlan *plan) {
+  if (db == NULL)
+    panic("db is NULL (scan_count)");
+  if (plan == NULL)
+    panic("plan is NULL (scan_count)");
+
+  struct Predicate predicate;
+  struct Predicate *where = NULL;
+  if (plan->where != NULL) {
+    predicate_init(&predicate, plan->tablemeta, plan->where->expr);
+    where = &predicate;
+  }
+
+  struct TableSource source;
+  openSource(&source, db, plan->tablemeta, plan->columns, where,
+             plan->limit < 0);
+
+  // without a where clause every record counts; with one, an index may
+  // know how many records match without looking at any of them
+  int count = source.numRecords;
+  bool counted = (where == NULL) || lookupIndex(db, &source, where,
+                                                plan->limit < 0, INT_MAX,
+                                                NULL, &count);
+  closeSource(&source);
+
+  if (!counted) { // scan the table after all, but make no result set
+    struct ColumnVectors *vectors = scan_vectors(db, plan);
+    count = vectors->numRows;
+    colvec_destroy(vectors);
+  }
+
+  return count;
+}
+
+//
+// scan_indexMinMax
+//
+bool scan_indexMinMax(struct Database *db, struct ScanPlan *plan, int column,
+                      bool max, int *value, int *numRows) {
+  if (db == NULL)
+    panic("db is NULL (scan_indexMinMax)");
+  if (plan == NULL)
+    panic("plan is NULL (scan_indexMinMax)");
+
+  struct TableMeta *tablemeta = plan->tablemeta;
+  if (!options_get()->useIndexes ||
+      tablemeta->columns[column].colType != COL_TYPE_INT ||
+      tablemeta->columns[column].indexType == COL_NON_INDEXED)
+    return false;
+
+  // the where clause, if any, must select a range of the same column
+  struct Predicate predicate;
+  struct Predicate *where = NULL;
+  if (plan->where != NULL) {
+    predicate_init(&predicate, tablemeta, plan->where->expr);
+    where = &predicate;
+
+    if (where->column != column || where->operator == EXPR_NOT_EQUAL ||
+        where->operator == EXPR_LIKE)
+      return false;
+  }
+
+  // the table's data is only needed if the index must be built first,
+  // and the indexer isn't building it already
+  struct BTree *btree = btree_open(db, tablemeta, column);
+  if (btree == NULL && plan->limit < 0 && !indexer_pending(tablemeta, column)) {
+    struct TableSource source;
+    openSource(&source, db, tablemeta, plan->columns, NULL, true);
+    btree = btree_build(db, tablemeta, column, source.cache, source.tablefile);
+    closeSource(&source);
+  }
+  if (btree == NULL)
+    return false;
+
+  int first = 0;
+  int last = 0;
+  findBTreeRange(db, tablemeta, btree, where, plan->limit < 0, &first, &last);
+
+  *numRows = last - first;
+  if (last > first)
+    *value = btree_key(btree, max ? last - 1 : first);
+
+  btree_close(btree);
+  return true;
+}
@@ -0,0 +1,104 @@
+/*scan.h*/
+
+//
+// Project: Table scans for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+
+#include "ast.h"
+#include "colvec.h"
+#include "database.h"
+
+//
+// A table is scanned in partitions of whole records. Small tables
+// are scanned by the calling thread; larger ones are split into
+// several partitions per thread, which a pool of worker threads
+// decode and filter independently. Partitions are never smaller
+// than this many records, so tiny scans don't pay for threads.
+//
+#define SCAN_MIN_PARTITION_RECORDS 16384
+#define SCAN_PARTITIONS_PER_THREAD 4
+
+//
+// Within a partition, records are filtered in batches of this many:
+// the where column of each record in the batch is decoded and tested
+// first, and only then are the other columns of the records that
+// passed decoded, so a rejected record costs one field.
+//
+#define SCAN_BATCH_RECORDS 1024
+
+//
+// A where clause on an indexed column is answered with the column's
+// index, unless more than 1 in this many records match it; then it
+// is cheaper to read the table from start to end.
+//
+#define SCAN_INDEX_MAX_FRACTION 4
+
+//
+// A ScanPlan describes what a scan should produce. Only the columns
+// the query refers to are decoded and stored; fields of the other
+// columns are skipped over in the records and never copied.
+//
+struct ScanPlan
+{
+  struct TableMeta* tablemeta;
+  bool*             columns;  // ARRAY: columns[i] => table column i is needed
+  struct WHERE*     where;    // OPTIONAL: rows must satisfy this
+  int               limit;    // OPTIONAL: stop after this many rows, -1 => all
+};
+
+
+//
+// Functions:
+//
+
+//
+// scan_vectors
+//
+// Reads the records of the plan's table into new column vectors,
+// with one column for each needed column of the table, in table
+// order. If the plan has a where clause, rows that don't satisfy
+// it are discarded; its column must be one of the needed ones.
+// The rows come out in the same order as the records in the
+// .data file, no matter how many threads are used.
+//
+// If the plan has a limit of N, the scan stops reading records as
+// soon as it has N rows, though it may return a few more; only the
+// first N of them are the answer.
+//
+// NOTE: it is the caller's responsibility to free the vectors
+// by calling colvec_destroy().
+//
+struct ColumnVectors* scan_vectors(struct Database* db, struct ScanPlan* plan);
+
+//
+// scan_count
+//
+// Returns the # of rows scan_vectors() would return for the plan,
+// ignoring its limit. When an index on the where clause's column can
+// count the matching records, e.g. as the popcount of a bitmap, the
+// records themselves are not read.
+//
+int scan_count(struct Database* db, struct ScanPlan* plan);
+
+//
+// scan_indexMinMax
+//
+// Computes the MIN (or if max is true, the MAX) of the given int
+// column over the rows scan_vectors() would return for the plan, using
+// only the column's B+tree index: the answer is the key of the first
+// (or last) entry in the range of entries the where clause selects.
+// The # of rows in the range is returned via numRows, and if it is
+// not 0, the answer via value. Returns false if the column has no
+// index, or the where clause is not a comparison on the same column;
+// then the rows must be scanned.
+//
+bool scan_indexMinMax(struct Database* db, struct ScanPlan* plan, int column,
+  bool max, int* value, int* numRows);
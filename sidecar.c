@@ -0,0 +1,141 @@
+/*sidecar.c*/
+
+//
+// Project: Sidecar files for SimpleSQL tables
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#define _DEFAULT_SOURCE // st_mtim, madvise under -std=c11
+
+#include <fcntl.h>     // open
+#include <stdatomic.h> // atomic_int
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int64_t, uint64_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>   // strcpy, strcat, memcmp, strnlen
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // stat
+#include <unistd.h>   // close, getpid
+
+#include "database.h"
+#include "sidecar.h"
+#include "util.h"
+
+//
+// sidecar_path
+//
+void sidecar_path(char *path, struct Database *db, struct TableMeta *tablemeta,
+                  char *ext) {
+  strcpy(path, db->name); // name/name.ext
+  strcat(path, "/");
+  strcat(path, tablemeta->name);
+  strcat(path, ext);
+}
+
+//
+// sidecar_stamp
+//
+bool sidecar_stamp(struct SidecarStamp *stamp, struct Database *db,
+                   struct TableMeta *tablemeta, char *magic) {
+  char dataPath[SIDECAR_MAX_PATH];
+  sidecar_path(dataPath, db, tablemeta, ".data");
+
+  struct stat info;
+  if (stat(dataPath, &info) < 0)
+    return false;
+
+  memset(stamp, 0, sizeof(struct SidecarStamp));
+  memcpy(stamp->magic, magic, strnlen(magic, sizeof(stamp->magic)));
+  stamp->dataSize = (uint64_t)info.st_size;
+  stamp->dataMtimeSec = (int64_t)info.st_mtim.tv_sec;
+  stamp->dataMtimeNsec = (int64_t)info.st_mtim.tv_nsec;
+  stamp->recordSize = tablemeta->recordSize;
+  stamp->numRecords = (int32_t)(info.st_size / (tablemeta->recordSize + 2));
+  return true;
+}
+
+//
+// sidecar_map
+//
+const char *sidecar_map(char *path, struct SidecarStamp *stamp, size_t *size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) // doesn't exist (yet)
+    return NULL;
+
+  struct stat info;
+  if (fstat(fd, &info) < 0 ||
+      (size_t)info.st_size < sizeof(struct SidecarStamp)) {
+    close(fd);
+    return NULL;
+  }
+
+  void *map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return NULL;
+
+  if (memcmp(map, stamp, sizeof(struct SidecarStamp)) != 0) { // stale
+    munmap(map, (size_t)info.st_size);
+    return NULL;
+  }
+
+  *size = (size_t)info.st_size;
+  return (const char *)map;
+}
+
+//
+// sidecar_unmap
+//
+void sidecar_unmap(const char *data, size_t size) {
+  if (data != NULL)
+    munmap((void *)data, size);
+}
+
+//
+// sidecar_create
+//
+FILE *sidecar_create(char *path, char *tempPath, struct SidecarStamp *stamp) {
+  // unique per process and thread, in case several build the same file
+  static atomic_int counter = 0;
+  int n = atomic_fetch_add(&counter, 1);
+  snprintf(tempPath, SIDECAR_MAX_PATH + 16, "%s.%d.%d.tmp", path, (int)getpid(),
+           n);
+
+  FILE *file = fopen(tempPath, "wb");
+  if (file == NULL)
+    return NULL;
+
+  fwrite(stamp, sizeof(struct SidecarStamp), 1, file);
+  return file;
+}
+
+//
+// sidecar_commit
+//
+bool sidecar_commit(FILE *file, char *tempPath, char *path) {
+  bool written = !ferror(file);
+  written = (fclose(file) == 0) && written;
+
+  if (written)
+    written = (rename(tempPath, path) == 0);
+  if (!written)
+    remove(tempPath);
+
+  return written;
+}
+
+//
+// sidecar_pad
+//
+uint64_t sidecar_pad(FILE *file) {
+  static const char zeros[8] = {0};
+  uint64_t position = (uint64_t)ftell(file);
+  uint64_t padding = (8 - (position % 8)) % 8;
+
+  fwrite(zeros, 1, padding, file);
+  return position + padding;
+}
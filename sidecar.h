@@ -0,0 +1,107 @@
+/*sidecar.h*/
+
+//
+// Project: Sidecar files for SimpleSQL tables
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+#include <stdint.h>  // int64_t, uint64_t
+#include <stdio.h>   // FILE
+
+#include "database.h"
+
+//
+// A sidecar is a file derived from a table's .data file and stored
+// next to it, e.g. "Movies.col" or "Movies.ID.idx". Every sidecar
+// begins with a SidecarStamp of the .data file it was derived from;
+// if the .data file no longer has that size and modification time,
+// the sidecar is stale and must be rebuilt.
+//
+// Sidecars are written to a temporary file which is then renamed
+// into place, so readers never see a partially written file.
+//
+struct SidecarStamp
+{
+  char     magic[8];      // identifies the kind of sidecar
+  uint64_t dataSize;      // size of the .data file
+  int64_t  dataMtimeSec;  // modification time of the .data file
+  int64_t  dataMtimeNsec;
+  int32_t  recordSize;    // the table's record size at the time
+  int32_t  numRecords;    // # of records in the .data file at the time
+};
+
+#define SIDECAR_MAX_PATH ((2 * DATABASE_MAX_ID_LENGTH) + DATABASE_MAX_ID_LENGTH + 16)
+
+
+//
+// Functions:
+//
+
+//
+// sidecar_path
+//
+// Builds "DB-NAME/TABLE-NAME.ext" into path, which must hold at least
+// SIDECAR_MAX_PATH chars; ext includes the leading '.', e.g. ".col"
+// or ".ID.idx".
+//
+void sidecar_path(char* path, struct Database* db, struct TableMeta* tablemeta,
+  char* ext);
+
+//
+// sidecar_stamp
+//
+// Fills in the stamp of the table's current .data file, with the
+// given magic (at most 8 chars). Returns false if the .data file
+// cannot be found.
+//
+bool sidecar_stamp(struct SidecarStamp* stamp, struct Database* db,
+  struct TableMeta* tablemeta, char* magic);
+
+//
+// sidecar_map
+//
+// Maps the sidecar at path into memory, read-only, if it exists and
+// begins with the given stamp. Returns NULL otherwise; on success
+// the # of bytes is returned via size.
+//
+const char* sidecar_map(char* path, struct SidecarStamp* stamp, size_t* size);
+
+//
+// sidecar_unmap
+//
+// Releases a mapping returned by sidecar_map.
+//
+void sidecar_unmap(const char* data, size_t size);
+
+//
+// sidecar_create
+//
+// Opens a temporary file to write the sidecar at path, and writes
+// the stamp to it. The name of the temporary file is returned via
+// tempPath, which must hold at least SIDECAR_MAX_PATH + 16 chars.
+// Returns NULL if the file cannot be created.
+//
+FILE* sidecar_create(char* path, char* tempPath, struct SidecarStamp* stamp);
+
+//
+// sidecar_commit
+//
+// Closes the temporary file and, if everything was written, renames
+// it to path. Returns true if the sidecar is now in place.
+//
+bool sidecar_commit(FILE* file, char* tempPath, char* path);
+
+//
+// sidecar_pad
+//
+// Writes zero bytes until the file position is a multiple of 8,
+// and returns the new position.
+//
+uint64_t sidecar_pad(FILE* file);
@@ -0,0 +1,163 @@
+/*tablefile.c*/
+
+//
+// Project: Memory-mapped table data files for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#define _DEFAULT_SOURCE // madvise, MADV_* under -std=c11
+
+#include <fcntl.h> // open
+#include <stdbool.h> // true, false
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // strcpy, strcat
+#include <sys/mman.h> // mmap, madvise
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // read, close
+
+#include "database.h"
+#include "tablefile.h"
+#include "util.h"
+
+// reads the entire file into a malloc'd buffer, used when the file
+// cannot be mapped; size is updated with the # of bytes actually read
+static char *readWholeFile(int fd, size_t *size) {
+  char *buffer = (char *)malloc(sizeof(char) * (*size + 1));
+  if (buffer == NULL)
+    panic("out of memory");
+
+  size_t total = 0;
+  while (total < *size) { // read may return less than requested
+    ssize_t n = read(fd, buffer + total, *size - total);
+    if (n <= 0)
+      break;
+    total += n;
+  }
+  buffer[total] = '\0';
+  *size = total;
+  return buffer;
+}
+
+//
+// tablefile_open
+//
+struct TableFile *tablefile_open(struct Database *db,
+                                 struct TableMeta *tablemeta) {
+  if (db == NULL)
+    panic("db is NULL (tablefile_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (tablefile_open)");
+
+  struct TableFile *tf = (struct TableFile *)malloc(sizeof(struct TableFile));
+  if (tf == NULL)
+    panic("out of memory");
+
+  strcpy(tf->path, db->name); // name/name.data
+  strcat(tf->path, "/");
+  strcat(tf->path, tablemeta->name);
+  strcat(tf->path, ".data");
+
+  int fd = open(tf->path, O_RDONLY);
+  if (fd < 0) { // unable to open:
+    free(tf);
+    return NULL;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) < 0) {
+    close(fd);
+    free(tf);
+    return NULL;
+  }
+
+  tf->size = (size_t)info.st_size;
+  tf->data = NULL;
+  tf->mapped = false;
+
+  if (tf->size > 0) { // mmap rejects a length of 0
+    void *map = mmap(NULL, tf->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      // we always walk the file front to back, so ask the kernel to
+      // read ahead aggressively and back it with huge pages if it can;
+      // these are only hints, so failures are ignored
+      madvise(map, tf->size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+      madvise(map, tf->size, MADV_HUGEPAGE);
+#endif
+      tf->data = (const char *)map;
+      tf->mapped = true;
+    }
+  }
+
+  if (tf->data == NULL) { // empty file, or the mapping failed:
+    tf->data = readWholeFile(fd, &tf->size);
+  }
+
+  close(fd); // the mapping stays valid after the descriptor is closed
+
+  //
+  // records are fixed-width, so the # of records follows from the size:
+  //
+  tf->recordSize = tablemeta->recordSize;
+  tf->stride = tablemeta->recordSize + 2; // ends with $\n
+  tf->numRecords = (int)(tf->size / tf->stride);
+
+  if (tf->size % tf->stride != 0 ||
+      (tf->numRecords > 0 && tf->data[tf->size - 1] != '\n')) {
+    printf("**INTERNAL ERROR: table's data file '%s' is not a whole # of "
+           "%d-byte records.\n",
+           tf->path, tf->stride);
+    panic("execution halted");
+  }
+
+  return tf;
+}
+
+//
+// tablefile_close
+//
+void tablefile_close(struct TableFile *tf) {
+  if (tf == NULL)
+    return;
+
+  if (tf->mapped)
+    munmap((void *)tf->data, tf->size);
+  else
+    free((void *)tf->data);
+
+  free(tf);
+}
+
+//
+// tablefile_record
+//
+const char *tablefile_record(struct TableFile *tf, int recNum) {
+  if (tf == NULL)
+    panic("tf is NULL (tablefile_record)");
+  if (recNum < 0 || recNum >= tf->numRecords)
+    panic("recNum param is invalid, must be 0..numRecords-1 "
+          "(tablefile_record)");
+
+  return tf->data + (size_t)recNum * tf->stride;
+}
+
+//
+// tablefile_records
+//
+const char *tablefile_records(struct TableFile *tf, int first, int last,
+                              size_t *numBytes) {
+  if (tf == NULL)
+    panic("tf is NULL (tablefile_records)");
+  if (first < 0 || first > last || last > tf->numRecords)
+    panic("range is invalid, must be 0 <= first <= last <= numRecords "
+          "(tablefile_records)");
+
+  if (numBytes != NULL)
+    *numBytes = (size_t)(last - first) * tf->stride;
+
+  return tf->data + (size_t)first * tf->stride;
+}
@@ -0,0 +1,86 @@
+/*tablefile.h*/
+
+//
+// Project: Memory-mapped table data files for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+
+#include "database.h"
+
+//
+// A TableFile is a read-only view of a table's underlying
+// "TABLE-NAME.data" file. The file is mapped into memory once,
+// so the engine can decode fields straight out of the mapped
+// bytes instead of copying every line into a buffer with fgets.
+// If the file cannot be mapped (e.g. it is empty), the contents
+// are read into a malloc'd buffer instead and the rest of the
+// engine cannot tell the difference.
+//
+// Every record is padded to the table's fixed recordSize and ends
+// with "$\n", so record N (0-based) always starts at byte offset
+// N * (recordSize + 2). The file is thus addressable by record
+// number, and the # of records follows from the file size.
+//
+struct TableFile
+{
+  char        path[(2 * DATABASE_MAX_ID_LENGTH) + 10]; // name/name.data
+  const char* data;   // first byte of the file contents
+  size_t      size;   // # of bytes in the file
+  bool        mapped; // true => data is mmap'd, false => malloc'd
+
+  int         recordSize; // # of bytes per record, excluding "$\n"
+  int         stride;     // # of bytes per record, including "$\n"
+  int         numRecords; // # of records in the file
+};
+
+//
+// Functions:
+//
+
+//
+// tablefile_open
+//
+// Opens and maps the .data file for the given table, which lives
+// in a sub-directory with the same name as the database. Returns
+// NULL if the file cannot be opened. The file must consist of
+// whole fixed-width records, otherwise this is an error.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling tablefile_close().
+//
+struct TableFile* tablefile_open(struct Database* db, struct TableMeta* tablemeta);
+
+//
+// tablefile_close
+//
+// Unmaps the file and frees the memory associated with it.
+//
+void tablefile_close(struct TableFile* tf);
+
+//
+// tablefile_record
+//
+// Returns a pointer to the first byte of record recNum, where
+// 0 <= recNum < tf->numRecords. The record is not null-terminated;
+// it ends with "$\n" after tf->recordSize bytes.
+//
+const char* tablefile_record(struct TableFile* tf, int recNum /*0..N-1*/);
+
+//
+// tablefile_records
+//
+// Returns a pointer to the first byte of the range of records
+// [first, last), where 0 <= first <= last <= tf->numRecords. The
+// records are contiguous, so the range spans numBytes bytes, which
+// is (last - first) * tf->stride; pass NULL if you don't need it.
+//
+const char* tablefile_records(struct TableFile* tf, int first /*0..N*/,
+  int last /*first..N*/, size_t* numBytes);
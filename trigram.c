@@ -0,0 +1,355 @@
+/*trigram.c*/
+
+//
+// Project: Trigram indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <ctype.h>   // tolower
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int32_t, uint32_t, uint64_t
+#include <stdio.h>
+#include <stdlib.h> // qsort
+#include <string.h> // memcpy, memset, strcpy, strcat
+
+#include "colcache.h"
+#include "database.h"
+#include "decoder.h"
+#include "sidecar.h"
+#include "tablefile.h"
+#include "trigram.h"
+#include "util.h"
+
+#define TRIGRAM_MAGIC "SSQLTRI1"
+
+//
+// On-disk layout: a TrigramHeader, followed by one TrigramEntry per
+// distinct trigram in ascending order, followed by the posting lists:
+// the int32_t record #s of each trigram, ascending. Offsets are from
+// the start of the file.
+//
+struct TrigramHeader
+{
+  struct SidecarStamp stamp;  // the .data file the index was built from
+  int32_t             column;
+  int32_t             colType;
+  int32_t             numTrigrams;
+  int32_t             unused;
+};
+
+struct TrigramEntry
+{
+  uint32_t trigram;   // the 3 lower-cased chars, first char highest
+  int32_t  count;     // # of records that contain it
+  uint64_t offset;    // its record #s
+};
+
+// builds ".COLUMN-NAME.tri", the extension of the index's sidecar
+static void buildExtension(char *ext, struct TableMeta *tablemeta, int column) {
+  strcpy(ext, ".");
+  strcat(ext, tablemeta->columns[column].name);
+  strcat(ext, ".tri");
+}
+
+// packs the 3 chars starting at s, lower-cased, into a trigram
+static uint32_t makeTrigram(const char *s) {
+  return ((uint32_t)(unsigned char)tolower((unsigned char)s[0]) << 16) |
+         ((uint32_t)(unsigned char)tolower((unsigned char)s[1]) << 8) |
+         (uint32_t)(unsigned char)tolower((unsigned char)s[2]);
+}
+
+// orders (trigram, record #) pairs, packed into one uint64_t each
+static int comparePairs(const void *a, const void *b) {
+  uint64_t p1 = *(const uint64_t *)a;
+  uint64_t p2 = *(const uint64_t *)b;
+  return (p1 < p2) ? -1 : (p1 > p2);
+}
+
+// returns the entry of the given trigram, or NULL if no record has it
+static const struct TrigramEntry *findTrigram(struct TrigramIndex *trigram,
+                                              uint32_t key) {
+  const struct TrigramEntry *entries =
+      (const struct TrigramEntry *)(trigram->data +
+                                    sizeof(struct TrigramHeader));
+  int lo = 0;
+  int hi = trigram->numTrigrams - 1;
+  while (lo <= hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (entries[mid].trigram == key)
+      return &entries[mid];
+    if (entries[mid].trigram < key)
+      lo = mid + 1;
+    else
+      hi = mid - 1;
+  }
+  return NULL;
+}
+
+//
+// trigram_open
+//
+struct TrigramIndex *trigram_open(struct Database *db,
+                                  struct TableMeta *tablemeta, int column) {
+  if (db == NULL)
+    panic("db is NULL (trigram_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (trigram_open)");
+
+  struct SidecarStamp stamp;
+  if (!sidecar_stamp(&stamp, db, tablemeta, TRIGRAM_MAGIC))
+    return NULL;
+
+  struct TrigramIndex *trigram =
+      (struct TrigramIndex *)malloc(sizeof(struct TrigramIndex));
+  if (trigram == NULL)
+    panic("out of memory");
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(trigram->path, db, tablemeta, ext);
+
+  // the index must have been built from the current .data file:
+  trigram->data = sidecar_map(trigram->path, &stamp, &trigram->size);
+  if (trigram->data == NULL) { // no index yet, or stale
+    free(trigram);
+    return NULL;
+  }
+
+  //
+  // ... and with the current meta-data:
+  //
+  const struct TrigramHeader *header =
+      (const struct TrigramHeader *)trigram->data;
+
+  bool valid = sizeof(struct TrigramHeader) <= trigram->size &&
+               header->column == column &&
+               header->colType == tablemeta->columns[column].colType &&
+               header->numTrigrams >= 0 &&
+               sizeof(struct TrigramHeader) +
+                       header->numTrigrams * sizeof(struct TrigramEntry) <=
+                   trigram->size;
+
+  if (!valid) { // damaged, the caller will rebuild it
+    sidecar_unmap(trigram->data, trigram->size);
+    free(trigram);
+    return NULL;
+  }
+
+  trigram->column = column;
+  trigram->numTrigrams = header->numTrigrams;
+
+  return trigram;
+}
+
+//
+// trigram_build
+//
+struct TrigramIndex *trigram_build(struct Database *db,
+                                   struct TableMeta *tablemeta, int column,
+                                   struct ColumnCache *cache,
+                                   struct TableFile *tablefile) {
+  if (db == NULL)
+    panic("db is NULL (trigram_build)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (trigram_build)");
+  if (cache == NULL && tablefile == NULL)
+    panic("cache and tablefile are NULL (trigram_build)");
+  if (tablemeta->columns[column].colType != COL_TYPE_STRING)
+    panic("only string columns have trigram indexes (trigram_build)");
+
+  struct TrigramHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!sidecar_stamp(&header.stamp, db, tablemeta, TRIGRAM_MAGIC))
+    return NULL;
+
+  int numRecords = (cache != NULL) ? cache->numRows : tablefile->numRecords;
+
+  //
+  // (1) collect every (trigram, record #) pair, and sort them; a
+  // trigram that occurs twice in one value becomes a duplicate pair,
+  // which is dropped below:
+  //
+  size_t numPairs = 0;
+  size_t capacity = 1024;
+  uint64_t *pairs = (uint64_t *)malloc(sizeof(uint64_t) * capacity);
+  bool *needed = (bool *)malloc(sizeof(bool) * tablemeta->numColumns);
+  struct FieldValue *values = (struct FieldValue *)malloc(
+      sizeof(struct FieldValue) * tablemeta->numColumns);
+  if (pairs == NULL || needed == NULL || values == NULL)
+    panic("out of memory");
+
+  for (int i = 0; i < tablemeta->numColumns; i++) {
+    needed[i] = (i == column);
+  }
+
+  struct RecordDecoder *decoder =
+      (cache == NULL) ? decoder_create(tablemeta, needed) : NULL;
+
+  for (int r = 0; r < numRecords; r++) {
+    if (cache != NULL)
+      colcache_decode(cache, r, needed, values);
+    else
+      decoder_decode(decoder, tablefile_record(tablefile, r), values);
+
+    const char *s = values[column].value.str.s;
+    int len = values[column].value.str.len;
+
+    if (numPairs + len > capacity) { // grow the array
+      capacity = (capacity + len) * 2;
+      pairs = (uint64_t *)realloc(pairs, sizeof(uint64_t) * capacity);
+      if (pairs == NULL)
+        panic("out of memory");
+    }
+
+    for (int i = 0; i + 3 <= len; i++) {
+      pairs[numPairs] = ((uint64_t)makeTrigram(s + i) << 32) | (uint32_t)r;
+      numPairs++;
+    }
+  }
+
+  decoder_destroy(decoder);
+  free(values);
+  free(needed);
+
+  qsort(pairs, numPairs, sizeof(uint64_t), comparePairs);
+
+  //
+  // (2) lay out the file: the entries, then the posting lists:
+  //
+  int numTrigrams = 0;
+  size_t numPostings = 0;
+  for (size_t p = 0; p < numPairs; p++) {
+    if (p > 0 && pairs[p] == pairs[p - 1]) // same trigram, same record
+      continue;
+    if (p == 0 || (pairs[p] >> 32) != (pairs[p - 1] >> 32))
+      numTrigrams++;
+    numPostings++;
+  }
+
+  struct TrigramEntry *entries = (struct TrigramEntry *)malloc(
+      sizeof(struct TrigramEntry) * numTrigrams + 1);
+  int32_t *postings = (int32_t *)malloc(sizeof(int32_t) * numPostings + 1);
+  if (entries == NULL || postings == NULL)
+    panic("out of memory");
+
+  uint64_t offset = sizeof(struct TrigramHeader) +
+                    (uint64_t)numTrigrams * sizeof(struct TrigramEntry);
+  int t = -1;
+  size_t n = 0;
+  for (size_t p = 0; p < numPairs; p++) {
+    if (p > 0 && pairs[p] == pairs[p - 1])
+      continue;
+    if (p == 0 || (pairs[p] >> 32) != (pairs[p - 1] >> 32)) { // a new one
+      t++;
+      entries[t].trigram = (uint32_t)(pairs[p] >> 32);
+      entries[t].count = 0;
+      entries[t].offset = offset + (n * sizeof(int32_t));
+    }
+    entries[t].count++;
+    postings[n] = (int32_t)(uint32_t)pairs[p];
+    n++;
+  }
+
+  free(pairs);
+
+  //
+  // (3) write to a temporary file and rename it into place:
+  //
+  header.column = column;
+  header.colType = COL_TYPE_STRING;
+  header.numTrigrams = numTrigrams;
+
+  char ext[DATABASE_MAX_ID_LENGTH + 16];
+  char indexPath[SIDECAR_MAX_PATH];
+  char tempPath[SIDECAR_MAX_PATH + 16];
+  buildExtension(ext, tablemeta, column);
+  sidecar_path(indexPath, db, tablemeta, ext);
+
+  bool written = false;
+  FILE *file = sidecar_create(indexPath, tempPath, &header.stamp);
+  if (file != NULL) {
+    fwrite(&header.column, sizeof(header) - sizeof(header.stamp), 1, file);
+    fwrite(entries, sizeof(struct TrigramEntry), numTrigrams, file);
+    fwrite(postings, sizeof(int32_t), numPostings, file);
+    written = sidecar_commit(file, tempPath, indexPath);
+  }
+
+  free(entries);
+  free(postings);
+
+  if (!written)
+    return NULL;
+
+  return trigram_open(db, tablemeta, column);
+}
+
+//
+// trigram_close
+//
+void trigram_close(struct TrigramIndex *trigram) {
+  if (trigram == NULL)
+    return;
+
+  sidecar_unmap(trigram->data, trigram->size);
+  free(trigram);
+}
+
+//
+// trigram_candidates
+//
+int *trigram_candidates(struct TrigramIndex *trigram, char *pattern,
+                        int *numCandidates) {
+  int *candidates = NULL;
+  int count = 0;
+
+  //
+  // every run of 3 literal chars --- no % or _ among them --- is a
+  // trigram the matching values must contain; the candidates are the
+  // intersection of their lists, which only ever shrinks:
+  //
+  int patternLen = (int)strlen(pattern);
+  for (int i = 0; i + 3 <= patternLen; i++) {
+    bool literal = true;
+    for (int j = i; j < i + 3; j++) {
+      if (pattern[j] == '%' || pattern[j] == '_')
+        literal = false;
+    }
+    if (!literal)
+      continue;
+
+    const struct TrigramEntry *entry =
+        findTrigram(trigram, makeTrigram(pattern + i));
+    const int32_t *list =
+        (entry != NULL) ? (const int32_t *)(trigram->data + entry->offset)
+                        : NULL;
+    int listLen = (entry != NULL) ? entry->count : 0;
+
+    if (candidates == NULL) { // the first one: take the whole list
+      candidates = (int *)malloc(sizeof(int) * (listLen + 1));
+      if (candidates == NULL)
+        panic("out of memory");
+      if (listLen > 0)
+        memcpy(candidates, list, sizeof(int32_t) * listLen);
+      count = listLen;
+      continue;
+    }
+
+    int kept = 0; // both lists are sorted, so merge them
+    int j = 0;
+    for (int c = 0; c < count && j < listLen; c++) {
+      while (j < listLen && list[j] < candidates[c])
+        j++;
+      if (j < listLen && list[j] == candidates[c]) {
+        candidates[kept] = candidates[c];
+        kept++;
+      }
+    }
+    count = kept;
+  }
+
+  *numCandidates = count;
+  return candidates;
+}
@@ -0,0 +1,94 @@
+/*trigram.h*/
+
+//
+// Project: Trigram indexes for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+
+#include "colcache.h"
+#include "database.h"
+#include "sidecar.h"
+#include "tablefile.h"
+
+//
+// A TrigramIndex speeds up LIKE on one string column of a table. For
+// every trigram --- every 3 consecutive chars, lower-cased --- that
+// occurs in the column, it holds the sorted list of record #s whose
+// value contains it. A record can only match '%star%' if it contains
+// both "sta" and "tar", so intersecting those two lists yields a short
+// list of candidates, and only the candidates are read and checked
+// against the pattern.
+//
+// The index is stored next to the table as
+// "TABLE-NAME.COLUMN-NAME.tri" and mapped into memory.
+//
+struct TrigramIndex
+{
+  char        path[SIDECAR_MAX_PATH]; // name/name.column.tri
+  const char* data;  // the mapped file
+  size_t      size;  // # of bytes in the file
+
+  int column;       // index of the column in the table (0-based)
+  int numTrigrams;  // # of distinct trigrams
+};
+
+
+//
+// Functions:
+//
+
+//
+// trigram_open
+//
+// Opens and maps the trigram index on the given column of the table.
+// Returns NULL if there is none, or if it does not match the table's
+// current .data file or meta-data.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling trigram_close().
+//
+struct TrigramIndex* trigram_open(struct Database* db,
+  struct TableMeta* tablemeta, int column);
+
+//
+// trigram_build
+//
+// Builds the trigram index on the given string column of the table,
+// writes it, replacing any existing one, and then opens it. The
+// values are read from the columnar cache if there is one, otherwise
+// decoded from the table file. Returns NULL if the index could not
+// be written.
+//
+struct TrigramIndex* trigram_build(struct Database* db,
+  struct TableMeta* tablemeta, int column, struct ColumnCache* cache,
+  struct TableFile* tablefile);
+
+//
+// trigram_close
+//
+// Unmaps the index and frees the memory associated with it.
+//
+void trigram_close(struct TrigramIndex* trigram);
+
+//
+// trigram_candidates
+//
+// Returns the record #s, in record order, of the records whose value
+// contains every trigram of the literal parts of the given LIKE
+// pattern; every record that matches the pattern is among them. The
+// # of candidates is returned via numCandidates. Returns NULL if the
+// pattern has no literal part of 3 or more chars, in which case the
+// index can't narrow the search.
+//
+// NOTE: it is the caller's responsibility to free the array.
+//
+int* trigram_candidates(struct TrigramIndex* trigram, char* pattern,
+  int* numCandidates);
@@ -0,0 +1,290 @@
+/*zonemap.c*/
+
+//
+// Project: Zone maps (per-block min/max) for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#include <stdbool.h> // true, false
+#include <stdint.h>  // int32_t, uint64_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memset
+
+#include "colcache.h"
+#include "database.h"
+#include "decoder.h"
+#include "predicate.h"
+#include "sidecar.h"
+#include "tablefile.h"
+#include "util.h"
+#include "zonemap.h"
+
+#define ZONEMAP_MAGIC "SSQLZMP1"
+
+//
+// On-disk layout: a ZoneHeader, followed by one ZoneColumnHeader per
+// column, followed by the numBlocks mins and then the numBlocks maxs
+// of each numeric column, as doubles. Offsets are from the start of
+// the file.
+//
+struct ZoneHeader
+{
+  struct SidecarStamp stamp;  // the .data file the zone map was built from
+  int32_t             numColumns;
+  int32_t             numBlocks;
+  int32_t             blockRecords;  // ZONEMAP_BLOCK_RECORDS at the time
+  int32_t             unused;
+};
+
+struct ZoneColumnHeader
+{
+  int32_t  colType;
+  int32_t  unused;
+  uint64_t offset;  // numeric columns only: the mins, then the maxs
+};
+
+//
+// zonemap_open
+//
+struct ZoneMap *zonemap_open(struct Database *db, struct TableMeta *tablemeta) {
+  if (db == NULL)
+    panic("db is NULL (zonemap_open)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (zonemap_open)");
+
+  struct SidecarStamp stamp;
+  if (!sidecar_stamp(&stamp, db, tablemeta, ZONEMAP_MAGIC))
+    return NULL;
+
+  struct ZoneMap *zonemap = (struct ZoneMap *)malloc(sizeof(struct ZoneMap));
+  if (zonemap == NULL)
+    panic("out of memory");
+
+  sidecar_path(zonemap->path, db, tablemeta, ".zmap");
+
+  // the zone map must have been built from the current .data file:
+  zonemap->data = sidecar_map(zonemap->path, &stamp, &zonemap->size);
+  if (zonemap->data == NULL) { // no zone map yet, or stale
+    free(zonemap);
+    return NULL;
+  }
+
+  //
+  // ... and with the current meta-data and block size:
+  //
+  const struct ZoneHeader *header = (const struct ZoneHeader *)zonemap->data;
+  const struct ZoneColumnHeader *colHeaders =
+      (const struct ZoneColumnHeader *)(zonemap->data +
+                                        sizeof(struct ZoneHeader));
+
+  bool valid = sizeof(struct ZoneHeader) <= zonemap->size &&
+               header->numColumns == tablemeta->numColumns &&
+               header->blockRecords == ZONEMAP_BLOCK_RECORDS &&
+               sizeof(struct ZoneHeader) +
+                       header->numColumns * sizeof(struct ZoneColumnHeader) <=
+                   zonemap->size;
+
+  for (int i = 0; valid && i < tablemeta->numColumns; i++) {
+    const struct ZoneColumnHeader *ch = &colHeaders[i];
+    valid = ch->colType == tablemeta->columns[i].colType &&
+            (ch->colType == COL_TYPE_STRING ||
+             ch->offset + 2 * (uint64_t)header->numBlocks * sizeof(double) <=
+                 zonemap->size);
+  }
+
+  if (!valid) { // damaged, the caller will rebuild it
+    sidecar_unmap(zonemap->data, zonemap->size);
+    free(zonemap);
+    return NULL;
+  }
+
+  //
+  // point the columns into the mapping:
+  //
+  zonemap->numRecords = header->stamp.numRecords;
+  zonemap->numBlocks = header->numBlocks;
+  zonemap->numColumns = header->numColumns;
+  zonemap->columns = (struct ZoneColumn *)malloc(sizeof(struct ZoneColumn) *
+                                                 zonemap->numColumns);
+  if (zonemap->columns == NULL)
+    panic("out of memory");
+
+  for (int i = 0; i < zonemap->numColumns; i++) {
+    const struct ZoneColumnHeader *ch = &colHeaders[i];
+    struct ZoneColumn *col = &zonemap->columns[i];
+
+    col->colType = ch->colType;
+    col->mins = NULL;
+    col->maxs = NULL;
+
+    if (ch->colType != COL_TYPE_STRING) {
+      col->mins = (const double *)(zonemap->data + ch->offset);
+      col->maxs = col->mins + zonemap->numBlocks;
+    }
+  }
+
+  return zonemap;
+}
+
+//
+// zonemap_build
+//
+struct ZoneMap *zonemap_build(struct Database *db, struct TableMeta *tablemeta,
+                              struct ColumnCache *cache,
+                              struct TableFile *tablefile) {
+  if (db == NULL)
+    panic("db is NULL (zonemap_build)");
+  if (tablemeta == NULL)
+    panic("tablemeta is NULL (zonemap_build)");
+  if (cache == NULL && tablefile == NULL)
+    panic("cache and tablefile are NULL (zonemap_build)");
+
+  // the zone map records which version of the .data file it came from
+  struct ZoneHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!sidecar_stamp(&header.stamp, db, tablemeta, ZONEMAP_MAGIC))
+    return NULL;
+
+  int numRecords = (cache != NULL) ? cache->numRows : tablefile->numRecords;
+  int numColumns = tablemeta->numColumns;
+  int numBlocks =
+      (numRecords + ZONEMAP_BLOCK_RECORDS - 1) / ZONEMAP_BLOCK_RECORDS;
+
+  //
+  // (1) lay out the file, and decide which columns to decode: only
+  // the numeric ones have a zone map
+  //
+  struct ZoneColumnHeader *colHeaders = (struct ZoneColumnHeader *)malloc(
+      sizeof(struct ZoneColumnHeader) * numColumns);
+  bool *needed = (bool *)malloc(sizeof(bool) * numColumns);
+  double **mins = (double **)malloc(sizeof(double *) * numColumns);
+  if (colHeaders == NULL || needed == NULL || mins == NULL)
+    panic("out of memory");
+
+  uint64_t offset = sizeof(struct ZoneHeader) +
+                    (uint64_t)numColumns * sizeof(struct ZoneColumnHeader);
+  for (int i = 0; i < numColumns; i++) {
+    int colType = tablemeta->columns[i].colType;
+    memset(&colHeaders[i], 0, sizeof(struct ZoneColumnHeader));
+    colHeaders[i].colType = colType;
+
+    needed[i] = (colType != COL_TYPE_STRING);
+    mins[i] = NULL;
+    if (!needed[i])
+      continue;
+
+    // the maxs follow the mins in the same array, as in the file
+    mins[i] = (double *)malloc(sizeof(double) * 2 * numBlocks + 1);
+    if (mins[i] == NULL)
+      panic("out of memory");
+
+    colHeaders[i].offset = offset;
+    offset += 2 * (uint64_t)numBlocks * sizeof(double);
+  }
+
+  //
+  // (2) one pass over the records, folding each numeric field into
+  // the min/max of its block:
+  //
+  struct RecordDecoder *decoder =
+      (cache == NULL) ? decoder_create(tablemeta, needed) : NULL;
+  struct FieldValue *values =
+      (struct FieldValue *)malloc(sizeof(struct FieldValue) * numColumns);
+  if (values == NULL)
+    panic("out of memory");
+
+  for (int r = 0; r < numRecords; r++) {
+    if (cache != NULL)
+      colcache_decode(cache, r, needed, values);
+    else
+      decoder_decode(decoder, tablefile_record(tablefile, r), values);
+
+    int block = r / ZONEMAP_BLOCK_RECORDS;
+    bool first = (r % ZONEMAP_BLOCK_RECORDS == 0);
+
+    for (int i = 0; i < numColumns; i++) {
+      if (!needed[i])
+        continue;
+
+      double value = (values[i].valueType == COL_TYPE_INT)
+                         ? (double)values[i].value.i
+                         : values[i].value.r;
+      double *min = &mins[i][block];
+      double *max = &mins[i][numBlocks + block];
+
+      if (first || value < *min)
+        *min = value;
+      if (first || value > *max)
+        *max = value;
+    }
+  }
+
+  free(values);
+  decoder_destroy(decoder);
+
+  //
+  // (3) write to a temporary file and rename it into place:
+  //
+  header.stamp.numRecords = numRecords;
+  header.numColumns = numColumns;
+  header.numBlocks = numBlocks;
+  header.blockRecords = ZONEMAP_BLOCK_RECORDS;
+
+  char zonemapPath[SIDECAR_MAX_PATH];
+  char tempPath[SIDECAR_MAX_PATH + 16];
+  sidecar_path(zonemapPath, db, tablemeta, ".zmap");
+
+  bool written = false;
+  FILE *file = sidecar_create(zonemapPath, tempPath, &header.stamp);
+  if (file != NULL) {
+    fwrite(&header.numColumns, sizeof(header) - sizeof(header.stamp), 1, file);
+    fwrite(colHeaders, sizeof(struct ZoneColumnHeader), numColumns, file);
+
+    for (int i = 0; i < numColumns; i++) {
+      if (needed[i])
+        fwrite(mins[i], sizeof(double), 2 * (size_t)numBlocks, file);
+    }
+
+    written = sidecar_commit(file, tempPath, zonemapPath);
+  }
+
+  for (int i = 0; i < numColumns; i++) {
+    free(mins[i]);
+  }
+  free(mins);
+  free(needed);
+  free(colHeaders);
+
+  if (!written)
+    return NULL;
+
+  return zonemap_open(db, tablemeta);
+}
+
+//
+// zonemap_close
+//
+void zonemap_close(struct ZoneMap *zonemap) {
+  if (zonemap == NULL)
+    return;
+
+  sidecar_unmap(zonemap->data, zonemap->size);
+  free(zonemap->columns);
+  free(zonemap);
+}
+
+//
+// zonemap_mayMatch
+//
+bool zonemap_mayMatch(struct ZoneMap *zonemap, struct Predicate *pred,
+                      int block) {
+  struct ZoneColumn *col = &zonemap->columns[pred->column];
+  if (col->mins == NULL || block >= zonemap->numBlocks) // nothing known
+    return true;
+
+  return predicate_mayMatchRange(pred, col->mins[block], col->maxs[block]);
+}
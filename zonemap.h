@@ -0,0 +1,100 @@
+/*zonemap.h*/
+
+//
+// Project: Zone maps (per-block min/max) for SimpleSQL
+//
+// Jeremy Chung
+// Northwestern University
+// CS 211, Winter 2023
+//
+
+#pragma once
+
+#include <stdbool.h> // true, false
+#include <stddef.h>  // size_t
+
+#include "colcache.h"
+#include "database.h"
+#include "predicate.h"
+#include "sidecar.h"
+#include "tablefile.h"
+
+//
+// A ZoneMap divides a table's records into blocks of
+// ZONEMAP_BLOCK_RECORDS consecutive records, and stores the minimum
+// and maximum value of each numeric column within each block. A scan
+// with a where clause on a numeric column can then skip every block
+// whose [min, max] range cannot satisfy the clause, without reading
+// the records at all.
+//
+// The zone map is stored next to the table as "TABLE-NAME.zmap",
+// and like the columnar cache it is only used while the .data file
+// is unchanged. It is small: 16 bytes per block per numeric column.
+//
+#define ZONEMAP_BLOCK_RECORDS 1024
+
+struct ZoneMap
+{
+  char        path[SIDECAR_MAX_PATH]; // name/name.zmap
+  const char* data;  // the mapped file
+  size_t      size;  // # of bytes in the file
+
+  int numRecords;
+  int numBlocks;
+  int numColumns;
+  struct ZoneColumn* columns;  // pointer to ARRAY of columns
+};
+
+struct ZoneColumn
+{
+  int colType;  // enum ColumnType (database.h)
+
+  const double* mins;  // numeric columns: numBlocks values, NULL for strings
+  const double* maxs;  // numeric columns: numBlocks values, NULL for strings
+};
+
+
+//
+// Functions:
+//
+
+//
+// zonemap_open
+//
+// Opens and maps the zone map for the given table. Returns NULL if
+// there is none, or if it does not match the table's current .data
+// file or meta-data.
+//
+// NOTE: it is the caller's responsibility to release the mapping
+// by calling zonemap_close().
+//
+struct ZoneMap* zonemap_open(struct Database* db, struct TableMeta* tablemeta);
+
+//
+// zonemap_build
+//
+// Computes the zone map of the given table, writes it, replacing any
+// existing one, and then opens it. The values are read from the
+// columnar cache if there is one, otherwise decoded from the table
+// file. Returns NULL if the zone map could not be written.
+//
+struct ZoneMap* zonemap_build(struct Database* db, struct TableMeta* tablemeta,
+  struct ColumnCache* cache, struct TableFile* tablefile);
+
+//
+// zonemap_close
+//
+// Unmaps the zone map and frees the memory associated with it.
+//
+void zonemap_close(struct ZoneMap* zonemap);
+
+//
+// zonemap_mayMatch
+//
+// Returns false if no record in the given block (0-based) can
+// satisfy the predicate, in which case the block can be skipped;
+// returns true if some record might. The predicate's column must
+// be numeric.
+//
+bool zonemap_mayMatch(struct ZoneMap* zonemap, struct Predicate* pred,
+  int block);